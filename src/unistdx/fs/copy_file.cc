@@ -32,91 +32,210 @@ For more information, please refer to <http://unlicense.org/>
 
 #include <unistdx/fs/copy_file>
 
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 #include <unistdx/config>
 #include <unistdx/fs/file_status>
 #include <unistdx/io/fildes>
+#include <unistdx/ipc/thread_pool>
 
 #if defined(UNISTDX_HAVE_COPY_FILE_RANGE)
 #include <unistd.h>
 #endif
-#if defined(UNISTDX_HAVE_SENDFILE)
-#include <sys/sendfile.h>
+#if defined(UNISTDX_HAVE_FICLONE)
+#include <linux/fs.h>
 #endif
 
+struct sys::file_copier::state {
+    const fildes& in;
+    const fildes& out;
+    offset_type total = 0;
+    offset_type copied = 0;
+    std::mutex mutex;
+    #if defined(UNISTDX_HAVE_COPY_FILE_RANGE)
+    std::atomic<bool> copy_file_range{true};
+    #endif
+
+    inline state(const fildes& a, const fildes& b): in(a), out(b) {}
+};
+
 namespace {
 
-    inline void
-    do_simple_copy(
-        sys::fildes& in,
-        sys::fildes& out,
-        sys::offset_type file_size
-    ) {
-        const size_t n = 4096;
-        char buf[n];
-        ssize_t nread = 0;
-        do {
-            ssize_t m = in.read(buf, n);
-            nread += m;
-            ssize_t nwritten = 0;
-            do { // LCOV_EXCL_LINE
-                nwritten += out.write(buf, m);
-            } while (nwritten != m);
-        } while (nread != file_size);
+    typedef std::pair<sys::offset_type,sys::offset_type> extent_type;
+
+    struct free_deleter {
+        inline void operator()(void* ptr) const noexcept { std::free(ptr); }
+    };
+
+    typedef std::unique_ptr<char,free_deleter> aligned_buffer;
+
+    inline aligned_buffer
+    allocate_aligned(size_t size) {
+        void* ptr = nullptr;
+        int ret = ::posix_memalign(&ptr, 4096, size);
+        if (ret != 0) { throw sys::bad_call(std::errc(ret)); }
+        return aligned_buffer(static_cast<char*>(ptr));
     }
 
-    #if defined(UNISTDX_HAVE_SENDFILE)
-    void
-    do_sendfile(
-        sys::fildes& in,
-        sys::fildes& out,
-        sys::offset_type size
-    ) {
-        sys::fd_type ifd = in.fd();
-        sys::fd_type ofd = out.fd();
-        sys::offset_type offset = 0;
-        ssize_t n;
-        while ((n = ::sendfile(ofd, ifd, &offset, size)) > 0) {
-            size -= n;
-        }
-        if (size != 0) {
-            if (errno != EINVAL && errno != ENOSYS) {
-                throw sys::bad_call(); // LCOV_EXCL_LINE
+    /// Returns true if the error means that the method is not supported.
+    inline bool
+    not_supported(int err) noexcept {
+        return err == ENOSYS || err == EXDEV || err == EBADF || err == EINVAL ||
+            err == EOPNOTSUPP || err == ENOTTY || err == ENOTSUP;
+    }
+
+    inline bool
+    reflink(const sys::fildes& in, const sys::fildes& out) {
+        #if defined(UNISTDX_HAVE_FICLONE)
+        if (::ioctl(out.fd(), FICLONE, in.fd()) == 0) { return true; }
+        if (!not_supported(errno)) { throw sys::bad_call(); }
+        #endif
+        return false;
+    }
+
+    std::vector<extent_type>
+    data_extents(const sys::fildes& in, sys::offset_type size, bool sparse) {
+        std::vector<extent_type> result;
+        #if defined(UNISTDX_HAVE_SEEK_DATA) && defined(UNISTDX_HAVE_SEEK_HOLE)
+        if (sparse) {
+            sys::offset_type offset = 0;
+            while (offset < size) {
+                auto first = ::lseek(in.fd(), offset, SEEK_DATA);
+                if (first == -1) {
+                    if (errno == ENXIO) { break; }
+                    if (!not_supported(errno)) { throw sys::bad_call(); }
+                    // keep the extents found so far, copy the rest as is
+                    result.emplace_back(offset, size-offset);
+                    break;
+                }
+                auto last = ::lseek(in.fd(), first, SEEK_HOLE);
+                if (last == -1) { throw sys::bad_call(); }
+                if (last > size) { last = size; }
+                if (first < last) { result.emplace_back(first, last-first); }
+                offset = last;
             }
-            do_simple_copy(in, out, size);
+            return result;
         }
+        #endif
+        if (size != 0) { result.emplace_back(0, size); }
+        return result;
     }
-    #endif
 
-    #if defined(UNISTDX_HAVE_COPY_FILE_RANGE)
     inline void
-    do_copy_file_range(
-        sys::fildes& in,
-        sys::fildes& out,
-        sys::offset_type size
-    ) {
-        sys::fd_type ifd = in.fd();
-        sys::fd_type ofd = out.fd();
-        ssize_t n;
-        while ((n = ::copy_file_range(ifd, nullptr, ofd, nullptr, size, 0)) > 0) {
-            size -= n;
+    preallocate(const sys::fildes& out, const extent_type& extent) {
+        #if defined(UNISTDX_HAVE_FALLOCATE)
+        if (::fallocate(out.fd(), 0, extent.first, extent.second) == -1 &&
+            !not_supported(errno)) {
+            throw sys::bad_call();
         }
-        if (size != 0) {
-            if (errno != EXDEV && errno != EBADF && errno != ENOSYS) {
-                throw sys::bad_call(); // LCOV_EXCL_LINE
-            }
-            #if defined(UNISTDX_HAVE_SENDFILE)
-            do_sendfile(in, out, size);
-            #else
-            do_simple_copy(in, out, size);
-            #endif
+        #endif
+    }
+
+}
+
+void
+sys::file_copier::copy_chunk(state& st, offset_type offset, offset_type size) {
+    auto report = [this,&st] (offset_type n) {
+        std::lock_guard<std::mutex> lock(st.mutex);
+        st.copied += n;
+        if (this->_progress) { this->_progress(st.copied, st.total); }
+    };
+    #if defined(UNISTDX_HAVE_COPY_FILE_RANGE)
+    while (size != 0 && st.copy_file_range) {
+        ::loff_t in_offset = offset, out_offset = offset;
+        auto n = ::copy_file_range(st.in.fd(), &in_offset, st.out.fd(), &out_offset,
+                                   size, 0);
+        if (n == -1) {
+            if (!not_supported(errno)) { throw bad_call(); }
+            st.copy_file_range = false;
+            break;
         }
+        if (n == 0) { return; } // the source file was truncated
+        offset += n, size -= n;
+        report(n);
     }
     #endif
+    if (size == 0) { return; }
+    const size_t buffer_size = this->_buffer_size;
+    auto buffer = allocate_aligned(buffer_size);
+    while (size != 0) {
+        size_t m = std::min(buffer_size, size_t(size));
+        ssize_t nread;
+        UNISTDX_CHECK(nread = ::pread(st.in.fd(), buffer.get(), m, offset));
+        if (nread == 0) { return; } // the source file was truncated
+        ssize_t nwritten = 0;
+        while (nwritten != nread) {
+            ssize_t k;
+            UNISTDX_CHECK(k = ::pwrite(st.out.fd(), buffer.get()+nwritten,
+                                       nread-nwritten, offset+nwritten));
+            nwritten += k;
+        }
+        offset += nread, size -= nread;
+        report(nread);
+    }
+}
 
+void
+sys::file_copier::copy(const fildes& in, const fildes& out, offset_type size) {
+    state st(in, out);
+    const bool sparse = bool(this->_flags & copy_flag::sparse);
+    if (bool(this->_flags & copy_flag::reflink) && reflink(in, out)) {
+        st.total = st.copied = size;
+        if (this->_progress) { this->_progress(st.copied, st.total); }
+        return;
+    }
+    auto extents = data_extents(in, size, sparse);
+    // set the size first to preserve the hole at the end of the file
+    UNISTDX_CHECK(::ftruncate(out.fd(), size));
+    std::vector<extent_type> chunks;
+    const offset_type chunk_size = this->_chunk_size > 0 ? this->_chunk_size : size;
+    for (const auto& extent : extents) {
+        if (bool(this->_flags & copy_flag::preallocate)) { preallocate(out, extent); }
+        st.total += extent.second;
+        for (offset_type i=0; i<extent.second; i+=chunk_size) {
+            chunks.emplace_back(extent.first+i, std::min(chunk_size, extent.second-i));
+        }
+    }
+    if (!this->_pool || chunks.size() <= 1) {
+        for (const auto& chunk : chunks) {
+            this->copy_chunk(st, chunk.first, chunk.second);
+        }
+        return;
+    }
+    std::atomic<size_t> pending{chunks.size()};
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::exception_ptr error;
+    for (const auto& chunk : chunks) {
+        this->_pool->submit([&,chunk] () {
+            try {
+                this->copy_chunk(st, chunk.first, chunk.second);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) { error = std::current_exception(); }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) { finished.notify_all(); }
+        });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] () { return pending == 0; });
+    if (error) { std::rethrow_exception(error); }
 }
 
 void
-sys::copy_file(const path& src, const path& dest) {
+sys::file_copier::copy(const path& src, const path& dest) {
     fildes in(
         src,
         open_flag::read_only |
@@ -131,13 +250,44 @@ sys::copy_file(const path& src, const path& dest) {
         open_flag::close_on_exec,
         0644
     );
-    file_status st(src);
-    const offset_type size = st.size();
-    #if defined(UNISTDX_HAVE_COPY_FILE_RANGE)
-    do_copy_file_range(in, out, size);
-    #elif defined(UNISTDX_HAVE_SENDFILE)
-    do_sendfile(in, out, size);
-    #else
-    do_simple_copy(in, out, size);
+    file_status st(in.fd());
+    this->copy(in, out, st.size());
+    copy_metadata(in, out, this->_flags);
+}
+
+void
+sys::copy_metadata(const fildes& in, fildes& out, copy_flag flags) {
+    if (!(flags & copy_flag::preserve_all)) { return; }
+    #if defined(UNISTDX_HAVE_SYS_XATTR_H)
+    if (bool(flags & copy_flag::preserve_attributes)) {
+        try {
+            for (const char* name : in.attributes()) {
+                try {
+                    out.attribute(name, in.attribute(name));
+                } catch (const bad_call& err) {
+                    if (err.errc() != std::errc::operation_not_permitted &&
+                        !not_supported(err.code().value())) {
+                        throw;
+                    }
+                }
+            }
+        } catch (const bad_call& err) {
+            if (!not_supported(err.code().value())) { throw; }
+        }
+    }
     #endif
+    file_status st(in.fd());
+    if (bool(flags & copy_flag::preserve_mode)) {
+        UNISTDX_CHECK(::fchmod(out.fd(), st.st_mode & 07777));
+    }
+    if (bool(flags & copy_flag::preserve_times)) {
+        ::timespec times[2] = {st.st_atim, st.st_mtim};
+        UNISTDX_CHECK(::futimens(out.fd(), times));
+    }
+}
+
+void
+sys::copy_file(const path& src, const path& dest) {
+    file_copier copier;
+    copier.copy(src, dest);
 }
@@ -33,6 +33,7 @@ For more information, please refer to <http://unlicense.org/>
 #include <unistdx/fs/copy_file>
 #include <unistdx/fs/file_status>
 #include <unistdx/io/fildes>
+#include <unistdx/ipc/thread_pool>
 
 #include <unistdx/test/language>
 #include <unistdx/test/random_string>
@@ -60,3 +61,42 @@ void test_copy_file_test_all() {
         sys::remove(dst);
     }
 }
+
+void test_copy_file_sparse() {
+    test::tmpdir tmp(UNISTDX_TMPDIR);
+    sys::path src(tmp.name(), "x");
+    sys::path dst(tmp.name(), "y");
+    const sys::offset_type mb = 1024L*1024L;
+    std::string data = test::random_string<char>(4096);
+    {
+        sys::fildes out(src, sys::open_flag::create | sys::open_flag::write_only, 0644);
+        for (auto offset : {sys::offset_type(0), 3*mb, 7*mb}) {
+            out.offset(offset);
+            out.write(data.data(), data.size());
+        }
+        out.truncate(10*mb);
+    }
+    sys::thread_pool pool(2);
+    sys::file_copier copier;
+    copier.pool(&pool);
+    copier.chunk_size(1024);
+    copier.buffer_size(1024);
+    sys::offset_type last_copied = 0, last_total = 0;
+    copier.progress([&] (sys::offset_type copied, sys::offset_type total) {
+        expect(value(last_copied) < value(copied));
+        last_copied = copied, last_total = total;
+    });
+    copier.copy(src, dst);
+    pool.stop();
+    pool.join();
+    expect(value(last_total) == value(last_copied));
+    sys::file_status src_status(src), dst_status(dst);
+    expect(value(src_status.size()) == value(dst_status.size()));
+    // holes are preserved
+    expect(value(dst_status.num_blocks()*512) < value(dst_status.size()));
+    std::stringstream orig;
+    orig << std::ifstream(src).rdbuf();
+    std::stringstream copy;
+    copy << std::ifstream(dst).rdbuf();
+    expect(value(orig.str() == copy.str()));
+}
@@ -1,6 +1,6 @@
 /*
 UNISTDX — C++ library for Linux system calls.
-© 2020 Ivan Gankevich
+© 2021 Ivan Gankevich
 
 This file is part of UNISTDX.
 
@@ -30,11 +30,46 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org/>
 */
 
-#include <errno.h>
-#include <sys/sendfile.h>
+#include <unistdx/fs/directory_reader>
 
-ssize_t
-sendfile(int, int, off_t*, size_t) noexcept {
-    errno = ENOSYS;
-    return -1;
+#if defined(SYS_getdents64)
+
+#include <fcntl.h>
+
+#include <unistdx/base/check>
+
+namespace {
+
+    constexpr const sys::open_flag directory_flags =
+        sys::open_flag::read_only |
+        sys::open_flag::directory |
+        sys::open_flag::close_on_exec;
+
+}
+
+void
+sys::directory_reader::open(path_view path) {
+    this->_fd = fildes(path, directory_flags);
+    this->_size = 0;
+}
+
+void
+sys::directory_reader::open(const fildes& dir, path_view path) {
+    this->_fd = fildes(check(::openat(dir.fd(), path, int(directory_flags))));
+    this->_size = 0;
 }
+
+bool
+sys::directory_reader::read(const fildes& dir) {
+    if (!this->_buffer) {
+        byte_buffer tmp(default_buffer_size);
+        this->_buffer.swap(tmp);
+    }
+    auto ret = call(calls::getdents64, dir.fd(),
+                    this->_buffer.data(), this->_buffer.size());
+    UNISTDX_CHECK(ret);
+    this->_size = static_cast<size_t>(ret);
+    return this->_size != 0;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistdx/fs/directory_reader>
+#include <unistdx/fs/file_status>
+
+#include <unistdx/test/language>
+#include <unistdx/test/operator>
+#include <unistdx/test/tmpdir>
+
+using namespace sys::test::lang;
+
+#if defined(SYS_getdents64)
+void test_directory_reader() {
+    std::vector<std::string> files;
+    for (int i=0; i<1000; ++i) { files.emplace_back("file-" + std::to_string(i)); }
+    test::tmpdir tdir(UNISTDX_TMPDIR, files.begin(), files.end());
+    // small buffer to read the directory in many batches
+    sys::directory_reader reader(tdir.name(), 4096);
+    std::set<std::string> actual, expected(files.begin(), files.end());
+    size_t nbatches = 0;
+    while (reader.read()) {
+        ++nbatches;
+        for (const auto& entry : reader) {
+            if (entry.is_working_dir() || entry.is_parent_dir()) { continue; }
+            actual.emplace(entry.name());
+            if (entry.has_type()) {
+                expect(value(sys::file_type::regular) == value(entry.type()));
+            }
+            sys::file_status status(sys::path(tdir.name(), entry.name()));
+            expect(value(status.st_ino) == value(entry.inode()));
+        }
+    }
+    expect(value(nbatches > 1));
+    expect(value(expected) == value(actual));
+    expect(!value(reader.read()));
+}
+
+void test_directory_reader_at() {
+    std::vector<std::string> files{"a", "b", "c"};
+    test::tmpdir tdir(UNISTDX_TMPDIR, files.begin(), files.end());
+    sys::fildes parent(".", sys::open_flag::read_only | sys::open_flag::directory);
+    sys::directory_reader reader(parent, tdir.name());
+    std::set<std::string> actual, expected(files.begin(), files.end());
+    reader.for_each([&] (const sys::directory_entry_view& entry) {
+        if (!entry.is_hidden()) { actual.emplace(entry.name()); }
+    });
+    expect(value(expected) == value(actual));
+}
+#endif
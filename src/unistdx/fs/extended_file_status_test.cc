@@ -0,0 +1,107 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistdx/fs/directory_reader>
+#include <unistdx/fs/extended_file_status>
+#include <unistdx/fs/file_status>
+#include <unistdx/io/fildes>
+
+#include <unistdx/test/exception>
+#include <unistdx/test/language>
+#include <unistdx/test/operator>
+#include <unistdx/test/tmpdir>
+
+using namespace sys::test::lang;
+
+#if defined(UNISTDX_HAVE_STATX)
+void test_extended_file_status_errors() {
+    UNISTDX_EXPECT_ERROR(
+        std::errc::no_such_file_or_directory,
+        sys::extended_file_status("non-existent-file")
+    );
+    sys::extended_file_status st;
+    expect(!st.exists());
+    UNISTDX_EXPECT_ERROR(
+        std::errc::no_such_file_or_directory,
+        st.update("non-existent-file", sys::status_field::type)
+    );
+}
+
+void test_extended_file_status_members() {
+    sys::file_status expected("src");
+    sys::extended_file_status st("src");
+    expect(st.exists());
+    expect(st.has(sys::status_field::basic));
+    expect(st.is_directory());
+    expect(!st.is_regular());
+    expect(!st.is_symbolic_link());
+    expect(value(expected.st_ino) == value(st.inode()));
+    expect(value(expected.size()) == value(st.size()));
+    expect(value(expected.mode()) == value(st.mode()));
+    expect(value(expected.device()) == value(st.device()));
+    expect(value(expected.num_links()) == value(st.num_links()));
+    expect(value(expected.owner()) == value(st.owner()));
+    expect(value(expected.group()) == value(st.group()));
+    expect(value(expected.last_modified() == st.last_modified()));
+    sys::fildes fd("src", sys::open_flag::read_only | sys::open_flag::directory);
+    sys::extended_file_status st_fd(fd.fd(), sys::status_field::type);
+    expect(st_fd.has(sys::status_field::type));
+    expect(st_fd.is_directory());
+    sys::extended_file_status st_sync("src",
+                                      sys::status_field::type | sys::status_field::size,
+                                      sys::path_flag(0), sys::status_sync::dont_sync);
+    expect(st_sync.has(sys::status_field::type | sys::status_field::size));
+    expect(value(expected.size()) == value(st_sync.size()));
+}
+
+void test_extended_file_status_batch() {
+    std::vector<std::string> files{"a", "b", "c", "d"};
+    test::tmpdir tdir(UNISTDX_TMPDIR, files.begin(), files.end());
+    sys::directory_reader reader(tdir.name());
+    std::set<std::string> actual, expected(files.begin(), files.end());
+    while (reader.read()) {
+        sys::for_each_status(
+            reader.fd().fd(), reader.begin(), reader.end(),
+            [&] (const sys::directory_entry_view& entry,
+                 const sys::extended_file_status& status) {
+                expect(value(entry.inode()) == value(status.inode()));
+                if (status.is_regular()) { actual.emplace(entry.name()); }
+            },
+            sys::status_field::type | sys::status_field::inode);
+    }
+    expect(value(expected) == value(actual));
+}
+#endif
@@ -0,0 +1,100 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/fs/file_system_watcher>
+
+#if defined(UNISTDX_HAVE_FANOTIFY_INIT)
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <string>
+#include <utility>
+
+sys::file_system_watcher::file_system_watcher(flag flags, size_t buffer_size):
+fildes{check(::fanotify_init(FAN_CLASS_NOTIF | unsigned(flags),
+                             O_RDONLY | O_LARGEFILE | O_CLOEXEC))},
+_buffer(new char[buffer_size]),
+_buffer_size(buffer_size) {}
+
+size_t
+sys::file_system_watcher::read(event_array& events) {
+    this->_coalesced.clear();
+    const auto old_size = events.size();
+    std::string link = "/proc/self/fd/";
+    const auto link_size = link.size();
+    char target[4096];
+    while (true) {
+        auto n = ::read(fd(), this->_buffer.get(), this->_buffer_size);
+        if (n == -1) {
+            if (errno == EAGAIN) { break; }
+            throw bad_call();
+        }
+        const char* first = this->_buffer.get();
+        const char* last = first + n;
+        while (first + sizeof(::fanotify_event_metadata) <= last) {
+            const auto* m = static_cast<const ::fanotify_event_metadata*>(
+                static_cast<const void*>(first));
+            if (m->event_len < sizeof(::fanotify_event_metadata) ||
+                first + m->event_len > last) {
+                break;
+            }
+            first += m->event_len;
+            event ev;
+            ev.mask = file_system_event(m->mask);
+            ev.process_id = m->pid;
+            if (m->fd >= 0) {
+                fildes event_fd(m->fd);
+                link.resize(link_size);
+                link += std::to_string(m->fd);
+                auto size = ::readlink(link.data(), target, sizeof(target));
+                if (size > 0) { ev.path = sys::path(std::string(target, size)); }
+            }
+            if (ev.path.empty()) {
+                events.emplace_back(std::move(ev));
+                continue;
+            }
+            auto result = this->_coalesced.emplace(ev.path, events.size());
+            if (result.second) {
+                events.emplace_back(std::move(ev));
+            } else {
+                events[result.first->second].mask |= ev.mask;
+            }
+        }
+        int nbytes = 0;
+        if (::ioctl(fd(), FIONREAD, &nbytes) == -1 || nbytes <= 0) { break; }
+    }
+    return events.size() - old_size;
+}
+
+#endif
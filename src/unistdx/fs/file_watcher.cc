@@ -0,0 +1,251 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/fs/file_watcher>
+
+#if defined(UNISTDX_HAVE_INOTIFY_INIT1) && defined(SYS_getdents64)
+
+#include <sys/ioctl.h>
+
+#include <utility>
+
+#include <unistdx/fs/file_status>
+
+namespace {
+
+    constexpr const std::uint32_t recursive_mask =
+        IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM;
+
+    constexpr const std::uint32_t always_reported =
+        IN_Q_OVERFLOW | IN_IGNORED | IN_UNMOUNT | IN_ISDIR;
+
+    inline bool
+    is_subdirectory(const sys::path& child, const sys::path& parent) noexcept {
+        const auto n = parent.size();
+        return child.size() >= n && child.compare(0, n, parent) == 0 &&
+            (child.size() == n || child[n] == '/');
+    }
+
+}
+
+sys::file_watcher::file_watcher(flag flags, size_t buffer_size):
+fildes{check(::inotify_init1(int(flags)))},
+_buffer(new char[buffer_size]),
+_buffer_size(buffer_size) {}
+
+auto
+sys::file_watcher::add(path_view p, watch_event mask) -> watch_type {
+    return this->add(p, mask, false);
+}
+
+auto
+sys::file_watcher::add(path_view p, watch_event mask, bool recursive) -> watch_type {
+    auto kernel_mask = std::uint32_t(mask) & IN_ALL_EVENTS;
+    if (recursive) { kernel_mask |= recursive_mask | IN_ONLYDIR; }
+    watch_type wd;
+    UNISTDX_CHECK(wd = ::inotify_add_watch(fd(), p, kernel_mask));
+    auto& w = this->_watches[wd];
+    w.path = sys::path(p);
+    w.mask = mask;
+    w.recursive = recursive;
+    return wd;
+}
+
+void
+sys::file_watcher::add_recursive(path_view dir, watch_event mask) {
+    this->add_recursive(sys::path(dir), mask, nullptr);
+}
+
+void
+sys::file_watcher::add_recursive(const sys::path& root, watch_event mask,
+                                 event_array* created) {
+    std::vector<sys::path> dirs{root};
+    directory_reader reader;
+    while (!dirs.empty()) {
+        sys::path dir(std::move(dirs.back()));
+        dirs.pop_back();
+        fildes dir_fd;
+        try {
+            this->add(dir, mask, true);
+            dir_fd = fildes(dir, open_flag::read_only | open_flag::directory |
+                            open_flag::close_on_exec);
+        } catch (const bad_call& err) {
+            // the directory was removed or replaced in the meantime
+            if (dir == root && !created) { throw; }
+            if (err.errc() == std::errc::no_such_file_or_directory ||
+                err.errc() == std::errc::not_a_directory) {
+                continue;
+            }
+            throw;
+        }
+        while (reader.read(dir_fd)) {
+            for (const auto& entry : reader) {
+                if (entry.is_working_dir() || entry.is_parent_dir()) { continue; }
+                auto type = entry.type();
+                if (!entry.has_type()) {
+                    file_status st;
+                    if (::fstatat(dir_fd.fd(), entry.name(), &st,
+                                  AT_SYMLINK_NOFOLLOW) == -1) {
+                        continue;
+                    }
+                    type = st.type();
+                }
+                sys::path p(dir, entry.name());
+                const bool is_dir = type == file_type::directory;
+                if (created) {
+                    event ev;
+                    ev.path = p;
+                    ev.mask = is_dir
+                        ? (watch_event::created | watch_event::is_directory)
+                        : watch_event::created;
+                    created->emplace_back(std::move(ev));
+                }
+                if (is_dir) { dirs.emplace_back(std::move(p)); }
+            }
+        }
+    }
+}
+
+void
+sys::file_watcher::remove(watch_type wd) {
+    UNISTDX_CHECK(::inotify_rm_watch(fd(), wd));
+    this->_watches.erase(wd);
+}
+
+void
+sys::file_watcher::remove_recursive(const sys::path& dir) {
+    auto first = this->_watches.begin();
+    while (first != this->_watches.end()) {
+        if (is_subdirectory(first->second.path, dir)) {
+            // the watch may be already removed by the kernel
+            ::inotify_rm_watch(fd(), first->first);
+            first = this->_watches.erase(first);
+        } else {
+            ++first;
+        }
+    }
+}
+
+size_t
+sys::file_watcher::read(event_array& events) {
+    this->_coalesced.clear();
+    const auto old_size = events.size();
+    while (true) {
+        auto n = ::read(fd(), this->_buffer.get(), this->_buffer_size);
+        if (n == -1) {
+            if (errno == EAGAIN) { break; }
+            throw bad_call();
+        }
+        this->decode(this->_buffer.get(), this->_buffer.get() + n, events);
+        // read the rest of the events without blocking
+        int nbytes = 0;
+        if (::ioctl(fd(), FIONREAD, &nbytes) == -1 || nbytes <= 0) { break; }
+    }
+    return events.size() - old_size;
+}
+
+void
+sys::file_watcher::decode(const char* first, const char* last, event_array& events) {
+    while (first != last) {
+        const auto* e = static_cast<const ::inotify_event*>(
+            static_cast<const void*>(first));
+        first += sizeof(::inotify_event) + e->len;
+        if (e->mask & IN_Q_OVERFLOW) {
+            event ev;
+            ev.mask = watch_event::overflow;
+            events.emplace_back(std::move(ev));
+            continue;
+        }
+        auto result = this->_watches.find(e->wd);
+        if (result == this->_watches.end()) { continue; }
+        const auto w = result->second;
+        event ev;
+        ev.path = e->len == 0 ? w.path : sys::path(w.path, e->name);
+        ev.mask = watch_event(e->mask);
+        ev.cookie = e->cookie;
+        ev.watch = e->wd;
+        if (e->mask & IN_IGNORED) { this->_watches.erase(result); }
+        if (w.recursive && (e->mask & IN_ISDIR)) {
+            if (e->mask & IN_MOVED_FROM) {
+                this->remove_recursive(ev.path);
+            }
+            if (e->mask & (IN_CREATE | IN_MOVED_TO)) {
+                event_array created;
+                try {
+                    this->add_recursive(ev.path, w.mask, &created);
+                } catch (const bad_call&) {
+                    // e.g. the limit on the number of watches is reached,
+                    // the subtree is not watched and its events are lost
+                    event overflow;
+                    overflow.path = ev.path;
+                    overflow.mask = watch_event::overflow;
+                    events.emplace_back(std::move(overflow));
+                }
+                this->push_back(events, event(ev));
+                for (auto& c : created) {
+                    if ((w.mask & watch_event::created) != watch_event{}) {
+                        this->push_back(events, std::move(c));
+                    }
+                }
+                continue;
+            }
+        }
+        this->push_back(events, std::move(ev));
+    }
+}
+
+void
+sys::file_watcher::push_back(event_array& events, event&& ev) {
+    auto it = this->_watches.find(ev.watch);
+    const auto user_mask = std::uint32_t(
+        it == this->_watches.end() ? watch_event::all : it->second.mask);
+    const auto m = std::uint32_t(ev.mask) & (user_mask | always_reported);
+    if ((m & ~std::uint32_t(IN_ISDIR)) == 0) { return; }
+    ev.mask = watch_event(m);
+    // the file is gone or replaced after these events, the following events
+    // start a new record, so that the last record reflects the final state
+    constexpr const auto delimiters = std::uint32_t(
+        IN_DELETE | IN_DELETE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF);
+    if (ev.cookie != 0 || (m & delimiters) != 0) {
+        this->_coalesced.erase(ev.path);
+        events.emplace_back(std::move(ev));
+        return;
+    }
+    auto result = this->_coalesced.emplace(ev.path, events.size());
+    if (result.second) {
+        events.emplace_back(std::move(ev));
+    } else {
+        events[result.first->second].mask |= ev.mask;
+    }
+}
+
+#endif
@@ -0,0 +1,208 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistdx/base/check>
+#include <unistdx/fs/canonical_path>
+#include <unistdx/fs/file_system_watcher>
+#include <unistdx/fs/file_watcher>
+#include <unistdx/io/poller>
+
+#include <unistdx/test/language>
+#include <unistdx/test/tmpdir>
+
+using namespace sys::test::lang;
+
+#if defined(UNISTDX_HAVE_INOTIFY_INIT1) && defined(SYS_getdents64)
+namespace {
+
+    using event_array = sys::file_watcher::event_array;
+
+    inline const sys::file_watcher::event*
+    find(const event_array& events, const sys::path& p) {
+        auto result = std::find_if(events.begin(), events.end(),
+                                   [&p] (const sys::file_watcher::event& e) {
+                                       return e.path == p;
+                                   });
+        return result == events.end() ? nullptr : &*result;
+    }
+
+    /// Read events until the event for \p p arrives or the timeout expires.
+    inline void
+    wait_for(sys::file_watcher& watcher, event_array& events, const sys::path& p) {
+        using namespace std::chrono;
+        sys::event_poller poller;
+        poller.emplace(watcher.fd(), sys::event::in);
+        std::mutex mtx;
+        std::unique_lock<std::mutex> lock(mtx);
+        auto deadline = steady_clock::now() + seconds(5);
+        while (!find(events, p) && steady_clock::now() < deadline) {
+            poller.wait_for(lock, milliseconds(100));
+            watcher.read(events);
+        }
+    }
+
+}
+
+void test_file_watcher_coalesce() {
+    test::tmpdir tdir(UNISTDX_TMPDIR);
+    sys::file_watcher watcher;
+    event_array events;
+    expect(value(0u) == value(watcher.read(events)));
+    auto wd = watcher.add(tdir.name());
+    expect(value(1u) == value(watcher.size()));
+    expect(value(sys::path(tdir.name())) == value(*watcher.find(wd)));
+    sys::path file(tdir.name(), "file");
+    for (int i=0; i<10; ++i) {
+        std::ofstream(file, std::ios::app) << i;
+    }
+    wait_for(watcher, events, file);
+    auto n = std::count_if(events.begin(), events.end(),
+                           [&file] (const sys::file_watcher::event& e) {
+                               return e.path == file;
+                           });
+    expect(value(1) == value(n));
+    auto* ev = find(events, file);
+    expect(value(ev != nullptr));
+    if (ev) {
+        expect(ev->has(sys::watch_event::created));
+        expect(ev->has(sys::watch_event::closed_write));
+        expect(!ev->is_directory());
+        expect(value(wd) == value(ev->watch));
+    }
+    watcher.remove(wd);
+    expect(watcher.empty());
+}
+
+void test_file_watcher_recreate() {
+    test::tmpdir tdir(UNISTDX_TMPDIR);
+    sys::file_watcher watcher;
+    event_array events;
+    watcher.add(tdir.name());
+    sys::path file(tdir.name(), "a"), other(tdir.name(), "b");
+    std::ofstream(file) << "old";
+    UNISTDX_CHECK(::rename(file, other));
+    std::ofstream(file) << "new";
+    wait_for(watcher, events, other);
+    watcher.read(events);
+    std::vector<sys::watch_event> masks;
+    for (const auto& e : events) {
+        if (e.path == file) { masks.emplace_back(e.mask); }
+    }
+    expect(value(3u) == value(masks.size()));
+    if (masks.size() == 3) {
+        expect(value((masks[0] & sys::watch_event::created) != sys::watch_event{}));
+        expect(value((masks[1] & sys::watch_event::moved_from) != sys::watch_event{}));
+        // the last record says that the file exists
+        expect(value((masks[2] & sys::watch_event::created) != sys::watch_event{}));
+        expect(value((masks[2] & (sys::watch_event::moved_from |
+                                  sys::watch_event::deleted)) == sys::watch_event{}));
+    }
+}
+
+void test_file_watcher_recursive() {
+    test::tmpdir tdir(UNISTDX_TMPDIR);
+    sys::path a(tdir.name(), "a");
+    sys::check(::mkdir(a, 0755));
+    sys::file_watcher watcher;
+    watcher.add_recursive(tdir.name());
+    expect(value(2u) == value(watcher.size()));
+    event_array events;
+    // file in an existing subdirectory
+    sys::path file_a(a, "x");
+    std::ofstream(file_a) << "x";
+    wait_for(watcher, events, file_a);
+    expect(value(find(events, file_a) != nullptr));
+    // new subdirectory is watched automatically
+    sys::path b(tdir.name(), "b");
+    sys::path c(b, "c");
+    sys::check(::mkdir(b, 0755));
+    sys::check(::mkdir(c, 0755));
+    wait_for(watcher, events, b);
+    sys::path file_c(c, "y");
+    std::ofstream(file_c) << "y";
+    wait_for(watcher, events, file_c);
+    auto* ev = find(events, b);
+    expect(value(ev != nullptr));
+    if (ev) { expect(ev->is_directory()); }
+    expect(value(find(events, file_c) != nullptr));
+    expect(value(4u) == value(watcher.size()));
+    // moved out subdirectory is not watched
+    sys::path moved(UNISTDX_TMPDIR_OUT);
+    sys::check(::rename(b, moved));
+    events.clear();
+    wait_for(watcher, events, b);
+    expect(value(2u) == value(watcher.size()));
+    sys::check(::rename(moved, b));
+    events.clear();
+    wait_for(watcher, events, c);
+    expect(value(4u) == value(watcher.size()));
+}
+#endif
+
+#if defined(UNISTDX_HAVE_FANOTIFY_INIT)
+void test_file_system_watcher() {
+    test::tmpdir tdir(UNISTDX_TMPDIR);
+    try {
+        sys::file_system_watcher watcher;
+        watcher.add(tdir.name(), sys::file_system_event::closed_write);
+        sys::path file(sys::canonical_path(tdir.name()), "file");
+        for (int i=0; i<3; ++i) {
+            std::ofstream(file, std::ios::app) << i;
+        }
+        sys::file_system_watcher::event_array events;
+        watcher.read(events);
+        auto n = std::count_if(events.begin(), events.end(),
+                               [&file] (const sys::file_system_watcher::event& e) {
+                                   return e.path == file;
+                               });
+        expect(value(1) == value(n));
+    } catch (const sys::bad_call& err) {
+        // fanotify requires CAP_SYS_ADMIN
+        if (err.errc() == std::errc::operation_not_permitted ||
+            err.errc() == std::errc::function_not_supported ||
+            err.errc() == std::errc::invalid_argument) {
+            return;
+        }
+        throw;
+    }
+}
+#endif
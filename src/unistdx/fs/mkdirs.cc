@@ -32,37 +32,104 @@ For more information, please refer to <http://unlicense.org/>
 
 #include <unistdx/fs/mkdirs>
 
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include <unistdx/base/check>
+#include <unistdx/bits/open_flag>
 #include <unistdx/fs/file_status>
+#include <unistdx/io/fildes>
+
+namespace {
+
+    // O_PATH does not require read permission, search permission is enough
+    constexpr const int directory_flags =
+        O_RDONLY | UNISTDX_O_PATH | O_DIRECTORY | O_CLOEXEC;
+
+    inline void
+    check_directory(sys::fd_type dir, const char* name) {
+        sys::file_status st(dir, name, sys::path_flag::no_follow);
+        if (!st.is_directory()) {
+            throw sys::bad_call(std::errc::not_a_directory);
+        }
+    }
+
+}
 
 void
 sys::mkdirs(sys::path dir, file_mode m, path::size_type offset) {
-    const sys::path::size_type n = dir.size();
+    sys::path::size_type n = dir.size();
     if (n == 0) {
         return;
     }
-    for (sys::path::size_type i=offset; i<n-1; ++i) {
-        const char ch = dir[i];
-        if (ch == '/') {
-            dir[i] = '\0';
-            int ret = ::mkdir(dir, m);
-            dir[i] = ch;
-            if (ret == -1 && errno != EEXIST) {
-                throw bad_call();
-            }
-        }
+    // fast path: the parent directory exists
+    if (::mkdir(dir, m) == 0) {
+        return;
+    }
+    if (errno == EEXIST) {
+        check_directory(AT_FDCWD, dir);
+        return;
+    }
+    if (errno != ENOENT) {
+        throw bad_call();
     }
-    int ret = ::mkdir(dir, m);
-    if (ret == -1) {
-        if (errno != EEXIST) {
+    while (n > 1 && dir[n-1] == '/') { --n; }
+    // walk backwards until an existing ancestor is found
+    fildes ancestor;
+    sys::path::size_type i = n;
+    while (i > offset) {
+        --i;
+        if (dir[i] != '/') { continue; }
+        dir[i] = '\0';
+        fd_type fd = ::open(dir, directory_flags);
+        dir[i] = '/';
+        if (fd != -1) {
+            ancestor = fildes(fd);
+            break;
+        }
+        if (errno != ENOENT) {
             throw bad_call();
         }
-        file_status st(dir, path_flag::no_follow);
-        if (!st.is_directory()) {
-            throw bad_call(std::errc::not_a_directory);
+    }
+    if (!ancestor) {
+        if (dir[0] == '/') {
+            fd_type fd = ::open("/", directory_flags);
+            UNISTDX_CHECK(fd);
+            ancestor = fildes(fd);
+        }
+        i = 0;
+    }
+    // create the remaining components downwards relative to the ancestor
+    fd_type parent = ancestor ? ancestor.fd() : fd_type(AT_FDCWD);
+    while (i < n) {
+        while (i < n && dir[i] == '/') { ++i; }
+        auto j = i;
+        while (j < n && dir[j] != '/') { ++j; }
+        if (i == j) { break; }
+        const char old = dir[j];
+        dir[j] = '\0';
+        const char* name = dir.data() + i;
+        const bool last = j == n;
+        if (::mkdirat(parent, name, m) == -1) {
+            if (errno != EEXIST) {
+                dir[j] = old;
+                throw bad_call();
+            }
+            if (last) {
+                check_directory(parent, name);
+            }
+        }
+        if (!last) {
+            fd_type fd = ::openat(parent, name, directory_flags);
+            if (fd == -1) {
+                dir[j] = old;
+                throw bad_call();
+            }
+            ancestor = fildes(fd);
+            parent = fd;
         }
+        dir[j] = old;
+        i = j;
     }
 }
@@ -30,10 +30,14 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org/>
 */
 
+#include <cstdlib>
+#include <iostream>
+
 #include <unistdx/fs/canonical_path>
 #include <unistdx/fs/file_status>
 #include <unistdx/fs/mkdirs>
 #include <unistdx/ipc/identity>
+#include <unistdx/ipc/process>
 #include <unistdx/test/language>
 #include <unistdx/test/temporary_file>
 
@@ -99,3 +103,40 @@ void test_mkdirs_file_in_path() {
         }
     }
 }
+
+void test_mkdirs_partially_exists() {
+    sys::path root(UNISTDX_TMPDIR);
+    test::tmpdir tdir_h(root);
+    sys::mkdirs(sys::path(root, "a", "b"));
+    sys::mkdirs(sys::path(root, "a", "b", "c", "d", "e/"), 0700);
+    sys::file_status st(sys::path(root, "a", "b", "c", "d", "e"));
+    expect(st.is_directory());
+    expect(value(sys::file_mode(0700)) == value(st.mode()));
+    sys::mkdirs(root, sys::path("x//y", "z"));
+    expect(sys::file_status(sys::path(root, "x", "y", "z")).is_directory());
+    sys::mkdirs(root, sys::path("x", "y", "z"));
+}
+
+void test_mkdirs_non_readable_ancestor() {
+    if (sys::this_process::user() != sys::superuser()) { std::exit(77); }
+    sys::path root(UNISTDX_TMPDIR);
+    test::tmpdir tdir_h(root);
+    sys::path ancestor(root, "search-only");
+    UNISTDX_CHECK(::mkdir(ancestor, 0733));
+    UNISTDX_CHECK(::chmod(ancestor, 0733));
+    sys::process child([&] () {
+        try {
+            sys::this_process::set_identity(65534, 65534);
+            sys::mkdirs(sys::path(ancestor, "a", "b", "c"));
+        } catch (const std::exception& err) {
+            std::clog << "Exception: " << err.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    });
+    sys::process_status status = child.wait();
+    if (!expect(value(0) == value(status.exit_code()))) {
+        std::clog << "status=" << status << std::endl;
+    }
+    expect(sys::file_status(sys::path(ancestor, "a", "b", "c")).is_directory());
+}
@@ -0,0 +1,96 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <unistdx/fs/parallel_dirtree>
+#include <unistdx/ipc/thread_pool>
+
+#include <unistdx/test/language>
+#include <unistdx/test/operator>
+#include <unistdx/test/tmpdir>
+
+using namespace sys::test::lang;
+
+#if defined(SYS_getdents64)
+void test_parallel_dirtree() {
+    std::vector<std::string> files{"a", "b", "c", ".hidden"};
+    test::tmpdir tdir(UNISTDX_TMPDIR, files.begin(), files.end());
+    std::vector<std::unique_ptr<test::tmpdir>> subdirs;
+    std::set<std::string> expected{"a", "b", "c"};
+    for (int i=0; i<10; ++i) {
+        auto d = "d" + std::to_string(i);
+        expected.emplace(d);
+        subdirs.emplace_back(new test::tmpdir(sys::path(UNISTDX_TMPDIR, d)));
+        for (int j=0; j<5; ++j) {
+            auto e = "e" + std::to_string(j);
+            expected.emplace(d + "/" + e);
+            for (const auto& f : files) {
+                if (f[0] != '.') { expected.emplace(d + "/" + e + "/" + f); }
+            }
+            subdirs.emplace_back(new test::tmpdir(
+                sys::path(UNISTDX_TMPDIR, d, e), files.begin(), files.end()));
+        }
+    }
+    std::vector<std::string> hidden_files{"x", "y"};
+    test::tmpdir hidden(sys::path(UNISTDX_TMPDIR, ".h"),
+                        hidden_files.begin(), hidden_files.end());
+    const std::string prefix = std::string(tdir.name()) + "/";
+    std::mutex mtx;
+    std::set<std::string> actual;
+    sys::thread_pool pool(4);
+    sys::parallel_dirtree tree(pool);
+    tree.walk(tdir.name(), [&] (const sys::path& dir,
+                                const sys::directory_entry_view& entry) {
+        std::string name(sys::path(dir, entry.name()));
+        std::lock_guard<std::mutex> lock(mtx);
+        actual.emplace(name.substr(prefix.size()));
+    });
+    expect(value(expected) == value(actual));
+    pool.stop();
+    pool.join();
+}
+
+void test_parallel_dirtree_nonexistent() {
+    sys::thread_pool pool(2);
+    sys::parallel_dirtree tree(pool);
+    expect(throws<sys::bad_call>(call([&] () {
+        tree.walk("/nonexistent-directory",
+                  [] (const sys::path&, const sys::directory_entry_view&) {});
+    })));
+    pool.stop();
+    pool.join();
+}
+#endif
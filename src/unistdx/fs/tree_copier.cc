@@ -0,0 +1,263 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/fs/tree_copier>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <unistdx/fs/file_status>
+#include <unistdx/io/fildes>
+
+#if defined(SYS_getdents64)
+
+namespace {
+
+    constexpr const int directory_flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+
+    inline sys::fd_type
+    open_at(sys::fd_type dir, const char* name, int flags, sys::mode_type mode=0) {
+        sys::fd_type fd;
+        UNISTDX_CHECK(fd = ::openat(dir, name, flags, mode));
+        return fd;
+    }
+
+}
+
+struct sys::tree_copier::directory {
+    tree_copier* copier;
+    fildes source;
+    fildes destination;
+    copy_flag flags{};
+
+    inline directory(tree_copier* c, fd_type src, fd_type dest, copy_flag f) noexcept:
+    copier(c), source(src), destination(dest), flags(f) {}
+
+    directory(const directory&) = delete;
+    directory& operator=(const directory&) = delete;
+
+    /**
+    Copy directory metadata after all entries are created.
+    The last owner releases the directory before calling
+    \link tree_copier::done \endlink, so the error reaches \link tree_copier::copy \endlink.
+    */
+    inline ~directory() noexcept {
+        try {
+            copy_metadata(this->source, this->destination, this->flags);
+        } catch (...) {
+            this->copier->error(std::current_exception());
+        }
+    }
+
+};
+
+sys::tree_copier::tree_copier(thread_pool& pool): _pool(pool) {}
+
+sys::tree_copy_statistics
+sys::tree_copier::copy(path_view src, path_view dest) {
+    fildes source(src, open_flag::read_only | open_flag::directory |
+                  open_flag::close_on_exec);
+    if (::mkdir(dest, 0755) == -1 && errno != EEXIST) { throw bad_call(); }
+    fildes destination(dest, open_flag::read_only | open_flag::directory |
+                       open_flag::close_on_exec);
+    this->_copier.pool(nullptr);
+    this->_copier.progress(nullptr);
+    this->_statistics = tree_copy_statistics{};
+    this->_start = clock_type::now();
+    this->_error = nullptr;
+    this->_pending = 1;
+    {
+        auto root = std::make_shared<directory>(this, source.fd(), destination.fd(),
+                                                this->_copier.flags());
+        source.release();
+        destination.release();
+        this->_pool.submit([this,root] () mutable { this->visit(std::move(root)); });
+    }
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    this->_finished.wait(lock, [this] () { return this->_pending == 0; });
+    this->_statistics.elapsed = clock_type::now() - this->_start;
+    if (this->_error) { std::rethrow_exception(this->_error); }
+    return this->_statistics;
+}
+
+void
+sys::tree_copier::visit(directory_ptr parent, const std::string& name) {
+    try {
+        const char* n = name.data();
+        if (::mkdirat(parent->destination.fd(), n, 0755) == -1 && errno != EEXIST) {
+            throw bad_call();
+        }
+        fildes src(open_at(parent->source.fd(), n, directory_flags));
+        fildes dest(open_at(parent->destination.fd(), n, directory_flags));
+        auto dir = std::make_shared<directory>(this, src.fd(), dest.fd(),
+                                               parent->flags);
+        src.release();
+        dest.release();
+        parent.reset();
+        this->update(0, 1, 0, 0);
+        this->visit(std::move(dir));
+    } catch (...) {
+        parent.reset();
+        this->error(std::current_exception());
+        this->done();
+    }
+}
+
+void
+sys::tree_copier::visit(directory_ptr dir) {
+    static thread_local directory_reader reader;
+    try {
+        while (reader.read(dir->source)) {
+            for (const auto& entry : reader) {
+                if (entry.is_working_dir() || entry.is_parent_dir()) { continue; }
+                // failure to copy one entry does not stop the copy of the others
+                try {
+                    this->copy_entry(dir, entry);
+                } catch (...) {
+                    this->error(std::current_exception());
+                }
+            }
+        }
+    } catch (...) {
+        this->error(std::current_exception());
+    }
+    dir.reset();
+    this->done();
+}
+
+void
+sys::tree_copier::copy_entry(const directory_ptr& dir, const directory_entry_view& entry) {
+    auto type = entry.type();
+    if (!entry.has_type()) {
+        type = file_status(dir->source.fd(), entry.name(), path_flag::no_follow).type();
+    }
+    switch (type) {
+        case file_type::directory: {
+            std::string name(entry.name());
+            this->submit([this,dir,name] () mutable {
+                this->visit(std::move(dir), name);
+            });
+            break;
+        }
+        case file_type::regular: {
+            std::string name(entry.name());
+            this->submit([this,dir,name] () mutable {
+                this->copy_file(std::move(dir), name);
+            });
+            break;
+        }
+        case file_type::symbolic_link:
+            this->copy_symbolic_link(dir, entry.name());
+            break;
+        default:
+            // sockets, pipes and devices are not copied
+            break;
+    }
+}
+
+void
+sys::tree_copier::copy_file(directory_ptr dir, const std::string& name) {
+    try {
+        fildes in(open_at(dir->source.fd(), name.data(), O_RDONLY | O_CLOEXEC));
+        fildes out(open_at(dir->destination.fd(), name.data(),
+                           O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        file_status st(in.fd());
+        this->_copier.copy(in, out, st.size());
+        copy_metadata(in, out, dir->flags);
+        this->update(1, 0, 0, st.size());
+    } catch (...) {
+        this->error(std::current_exception());
+    }
+    dir.reset();
+    this->done();
+}
+
+void
+sys::tree_copier::copy_symbolic_link(const directory_ptr& dir, const char* name) {
+    file_status st(dir->source.fd(), name, path_flag::no_follow);
+    std::string target(st.size()+1, '\0');
+    ssize_t n;
+    UNISTDX_CHECK(n = ::readlinkat(dir->source.fd(), name, &target[0], target.size()));
+    target.resize(n);
+    if (::symlinkat(target.data(), dir->destination.fd(), name) == -1) {
+        if (errno != EEXIST) { throw bad_call(); }
+        UNISTDX_CHECK(::unlinkat(dir->destination.fd(), name, 0));
+        UNISTDX_CHECK(::symlinkat(target.data(), dir->destination.fd(), name));
+    }
+    if (bool(dir->flags & copy_flag::preserve_times)) {
+        ::timespec times[2] = {st.st_atim, st.st_mtim};
+        UNISTDX_CHECK(::utimensat(dir->destination.fd(), name, times,
+                                  AT_SYMLINK_NOFOLLOW));
+    }
+    this->update(0, 0, 1, 0);
+}
+
+void
+sys::tree_copier::submit(std::function<void()> task) {
+    ++this->_pending;
+    try {
+        this->_pool.submit(std::move(task));
+    } catch (...) {
+        --this->_pending;
+        throw;
+    }
+}
+
+void
+sys::tree_copier::update(size_t files, size_t directories, size_t symbolic_links,
+                         offset_type bytes) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    auto& s = this->_statistics;
+    s.files += files;
+    s.directories += directories;
+    s.symbolic_links += symbolic_links;
+    s.bytes += bytes;
+    s.elapsed = clock_type::now() - this->_start;
+    if (this->_progress) { this->_progress(s); }
+}
+
+void
+sys::tree_copier::error(std::exception_ptr ptr) {
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if (!this->_error) { this->_error = ptr; }
+}
+
+void
+sys::tree_copier::done() {
+    // the task must release its directories before this call,
+    // so that directory metadata is copied before copy() returns
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if (--this->_pending == 0) { this->_finished.notify_all(); }
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistdx/fs/file_status>
+#include <unistdx/fs/tree_copier>
+#include <unistdx/ipc/thread_pool>
+
+#include <unistdx/test/language>
+#include <unistdx/test/random_string>
+#include <unistdx/test/tmpdir>
+
+using namespace sys::test::lang;
+
+#if defined(SYS_getdents64)
+namespace {
+
+    inline std::string
+    read_file(const sys::path& p) {
+        std::stringstream tmp;
+        tmp << std::ifstream(p).rdbuf();
+        return tmp.str();
+    }
+
+}
+
+void test_tree_copier() {
+    test::tmpdir tmp(UNISTDX_TMPDIR);
+    sys::path src(tmp.name(), "src");
+    sys::path dst(tmp.name(), "dst");
+    std::vector<sys::path> files;
+    sys::check(::mkdir(src, 0755));
+    for (int i=0; i<4; ++i) {
+        sys::path dir(src, "d" + std::to_string(i));
+        sys::check(::mkdir(dir, 0750));
+        sys::check(::mkdir(sys::path(dir, "e"), 0700));
+        for (int j=0; j<8; ++j) {
+            files.emplace_back(dir, "f" + std::to_string(j));
+            files.emplace_back(sys::path(dir, "e"), "g" + std::to_string(j));
+        }
+    }
+    files.emplace_back(src, ".hidden");
+    size_t size = 0;
+    for (const auto& f : files) {
+        auto data = test::random_string<char>(size % 10000);
+        std::ofstream(f) << data;
+        sys::check(::chmod(f, size % 2 == 0 ? 0600 : 0640));
+        size += data.size() + 1;
+    }
+    sys::check(::symlink("d0/f0", sys::path(src, "link")));
+    ::timespec times[2] = {{1000,0}, {2000,0}};
+    sys::check(::utimensat(AT_FDCWD, files.front(), times, 0));
+    sys::thread_pool pool(4);
+    sys::tree_copier copier(pool);
+    copier.copier().flags(copier.copier().flags() | sys::copy_flag::preserve_all);
+    size_t num_calls = 0;
+    copier.progress([&] (const sys::tree_copy_statistics&) { ++num_calls; });
+    auto stats = copier.copy(src, dst);
+    pool.stop();
+    pool.join();
+    expect(value(files.size()) == value(stats.files));
+    expect(value(8u) == value(stats.directories));
+    expect(value(1u) == value(stats.symbolic_links));
+    expect(value(stats.files + stats.directories + stats.symbolic_links) ==
+           value(num_calls));
+    expect(value(stats.throughput() >= 0));
+    sys::offset_type total = 0;
+    for (const auto& f : files) {
+        sys::path g(dst, f.substr(src.size()+1));
+        expect(value(read_file(f)) == value(read_file(g)));
+        sys::file_status a(f), b(g);
+        expect(value(a.mode()) == value(b.mode()));
+        expect(value(a.last_modified() == b.last_modified()));
+        total += a.size();
+    }
+    expect(value(total) == value(stats.bytes));
+    sys::file_status a(sys::path(src, "d0")), b(sys::path(dst, "d0"));
+    expect(value(a.mode()) == value(b.mode()));
+    expect(value(a.last_modified() == b.last_modified()));
+    char target[64]{};
+    sys::check(::readlink(sys::path(dst, "link"), target, sizeof(target)-1));
+    expect(value(std::string("d0/f0")) == value(std::string(target)));
+}
+
+void test_tree_copier_continue_after_error() {
+    test::tmpdir tmp(UNISTDX_TMPDIR);
+    sys::path src(tmp.name(), "src");
+    sys::path dst(tmp.name(), "dst");
+    sys::check(::mkdir(src, 0755));
+    std::vector<sys::path> files;
+    for (int i=0; i<16; ++i) {
+        files.emplace_back(src, "f" + std::to_string(i));
+        std::ofstream(files.back()) << i;
+        sys::check(::symlink("f0", sys::path(src, "l" + std::to_string(i))));
+    }
+    sys::check(::mkdir(sys::path(src, "d"), 0755));
+    files.emplace_back(sys::path(src, "d"), "f");
+    std::ofstream(files.back()) << "f";
+    // the symbolic link can not replace non-empty directory
+    sys::check(::mkdir(dst, 0755));
+    sys::check(::mkdir(sys::path(dst, "l0"), 0755));
+    sys::check(::mkdir(sys::path(dst, "l0", "x"), 0755));
+    sys::thread_pool pool(2);
+    sys::tree_copier copier(pool);
+    expect(throws<sys::bad_call>(call([&] () { copier.copy(src, dst); })));
+    pool.stop();
+    pool.join();
+    for (const auto& f : files) {
+        sys::path g(dst, f.substr(src.size()+1));
+        expect(value(read_file(f)) == value(read_file(g)));
+    }
+    for (int i=1; i<16; ++i) {
+        sys::file_status st(sys::path(dst, "l" + std::to_string(i)), sys::path_flag::no_follow);
+        expect(st.is_symbolic_link());
+    }
+}
+
+void test_tree_copier_nonexistent() {
+    sys::thread_pool pool(2);
+    sys::tree_copier copier(pool);
+    expect(throws<sys::bad_call>(call([&] () {
+        copier.copy("/nonexistent-directory", "/tmp/nonexistent-directory");
+    })));
+    pool.stop();
+    pool.join();
+}
+#endif
@@ -0,0 +1,85 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <cstdlib>
+#include <sys/stat.h>
+
+#include <unistdx/config>
+
+#if defined(UNISTDX_HAVE_BLKSSZGET)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#include <unistdx/base/check>
+#include <unistdx/io/aligned_buffer>
+#include <unistdx/system/resource>
+
+sys::direct_io_alignment::direct_io_alignment(const fildes& fd) {
+    #if defined(UNISTDX_HAVE_STATX_DIOALIGN)
+    struct ::statx st{};
+    UNISTDX_CHECK(::statx(fd.fd(), "", AT_EMPTY_PATH, STATX_DIOALIGN, &st));
+    if ((st.stx_mask & STATX_DIOALIGN) && st.stx_dio_offset_align != 0) {
+        this->_memory = st.stx_dio_mem_align;
+        this->_offset = st.stx_dio_offset_align;
+        return;
+    }
+    #endif
+    #if defined(UNISTDX_HAVE_BLKSSZGET)
+    struct ::stat s{};
+    UNISTDX_CHECK(::fstat(fd.fd(), &s));
+    if (S_ISBLK(s.st_mode)) {
+        int block_size = 0;
+        UNISTDX_CHECK(::ioctl(fd.fd(), BLKSSZGET, &block_size));
+        this->_memory = this->_offset = block_size;
+        return;
+    }
+    #endif
+    this->_memory = this->_offset = page_size();
+}
+
+sys::aligned_buffer::aligned_buffer(size_type size, size_type alignment):
+_alignment(alignment) {
+    if (alignment < sizeof(void*)) { this->_alignment = alignment = sizeof(void*); }
+    if (size % alignment != 0) { size += alignment - size%alignment; }
+    void* ptr = nullptr;
+    if (int ret = ::posix_memalign(&ptr, alignment, size)) {
+        throw bad_call(std::errc(ret));
+    }
+    this->_data = static_cast<value_type*>(ptr);
+    this->_size = size;
+}
+
+void sys::aligned_buffer::free() noexcept {
+    std::free(this->_data);
+    this->_data = nullptr;
+}
@@ -0,0 +1,145 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include <unistdx/fs/file_status>
+#include <unistdx/io/aligned_buffer>
+#include <unistdx/io/direct_fildesbuf>
+
+#include <unistdx/test/language>
+#include <unistdx/test/random_string>
+#include <unistdx/test/temporary_file>
+
+using namespace sys::test::lang;
+
+void test_aligned_buffer() {
+    sys::aligned_buffer buf(1000, 4096);
+    expect(static_cast<bool>(buf));
+    expect(value(4096u) == value(buf.size()));
+    expect(value(4096u) == value(buf.alignment()));
+    expect(value(0u) == value(reinterpret_cast<std::uintptr_t>(buf.data()) % 4096));
+    sys::aligned_buffer other(std::move(buf));
+    expect(!buf);
+    expect(value(4096u) == value(other.size()));
+    expect(throws<sys::bad_call>(call([] () { sys::aligned_buffer(10, 24); })));
+}
+
+void test_direct_io_alignment() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    sys::fildes f(tmp.path(), sys::open_flag::read_only);
+    sys::direct_io_alignment a(f);
+    expect(a.memory() != 0u);
+    expect(a.offset() != 0u);
+    expect(value(0u) == value(a.block_size() % a.offset()));
+    expect(value(0u) == value(a.block_size() % a.memory()));
+}
+
+void test_direct_fildesbuf() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    sys::fildes f;
+    try {
+        f.open(tmp.path(), sys::open_flag::write_only | sys::open_flag::direct);
+    } catch (const sys::bad_call& err) {
+        // the file system does not support direct input/output
+        if (err.errc() == std::errc::invalid_argument) { return; }
+        throw;
+    }
+    std::string expected;
+    {
+        sys::direct_fildesbuf buf(std::move(f), 3*4096);
+        std::ostream out(&buf);
+        for (int i=0; i<100; ++i) {
+            auto chunk = test::random_string<char>(i*173 % 5000);
+            out.write(chunk.data(), chunk.size());
+            expected += chunk;
+            if (i == 50) {
+                out.flush();
+                expect(value(sys::offset_type(expected.size())) ==
+                       value(sys::file_status(tmp.path()).size()));
+            }
+        }
+        out.put('x');
+        expected += 'x';
+        expect(value(sys::offset_type(expected.size())) == value(buf.offset()));
+        buf.close();
+    }
+    expect(value(sys::offset_type(expected.size())) ==
+           value(sys::file_status(tmp.path()).size()));
+    sys::fildes in(tmp.path(), sys::open_flag::read_only);
+    std::string actual(expected.size(), '\0');
+    size_t n = 0;
+    while (n != actual.size()) { n += in.read(&actual[n], actual.size()-n); }
+    expect(value(expected) == value(actual));
+    expect(throws<sys::bad_call>(call([&] () {
+        sys::direct_fildesbuf(sys::fildes(tmp.path(), sys::open_flag::write_only),
+                              4096, 1);
+    })));
+}
+
+void test_direct_fildesbuf_overwrite() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    std::string expected = test::random_string<char>(3*4096 + 100);
+    {
+        sys::fildes out(tmp.path(), sys::open_flag::write_only);
+        out.write(expected.data(), expected.size());
+    }
+    sys::fildes f;
+    try {
+        f.open(tmp.path(), sys::open_flag::read_write | sys::open_flag::direct);
+    } catch (const sys::bad_call& err) {
+        if (err.errc() == std::errc::invalid_argument) { return; }
+        throw;
+    }
+    auto read_all = [&tmp] () {
+        sys::fildes in(tmp.path(), sys::open_flag::read_only);
+        std::string actual(sys::file_status(tmp.path()).size(), '\0');
+        size_t n = 0;
+        while (n != actual.size()) { n += in.read(&actual[n], actual.size()-n); }
+        return actual;
+    };
+    sys::direct_fildesbuf buf(std::move(f), 4096, 4096, sys::direct_io_alignment(512, 4096));
+    std::ostream out(&buf);
+    // overwrite in the middle of the file
+    out << "0123456789";
+    out.flush();
+    expected.replace(4096, 10, "0123456789");
+    expect(value(expected) == value(read_all()));
+    // overwrite the last incomplete block and extend the file
+    std::string tail = test::random_string<char>(2*4096);
+    out.write(tail.data(), tail.size());
+    buf.close();
+    expected.replace(4096+10, tail.size(), tail);
+    expect(value(expected) == value(read_all()));
+}
@@ -0,0 +1,115 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <unistdx/base/check>
+#include <unistdx/io/fiber_io>
+
+namespace {
+
+    inline sys::fiber_scheduler&
+    current_scheduler() {
+        auto s = sys::this_fiber::scheduler();
+        if (!s || !sys::this_fiber::get()) {
+            throw sys::bad_call(std::errc::operation_not_permitted);
+        }
+        return *s;
+    }
+
+    inline bool
+    would_block() noexcept {
+        #if EAGAIN == EWOULDBLOCK
+        return errno == EAGAIN;
+        #else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+        #endif
+    }
+
+}
+
+ssize_t sys::this_fiber::read(const fildes& in, void* buf, size_t n) {
+    auto& s = current_scheduler();
+    while (true) {
+        auto ret = ::read(in.fd(), buf, n);
+        if (ret != -1) { return ret; }
+        if (errno == EINTR) { continue; }
+        if (!would_block()) { throw bad_call(); }
+        s.wait(in.fd(), event::in);
+    }
+}
+
+ssize_t sys::this_fiber::write(const fildes& out, const void* buf, size_t n) {
+    auto& s = current_scheduler();
+    while (true) {
+        auto ret = ::write(out.fd(), buf, n);
+        if (ret != -1) { return ret; }
+        if (errno == EINTR) { continue; }
+        if (!would_block()) { throw bad_call(); }
+        s.wait(out.fd(), event::out);
+    }
+}
+
+void sys::this_fiber::accept(socket& server, socket& client, socket_address& client_address) {
+    auto& s = current_scheduler();
+    while (!server.accept(client, client_address)) {
+        s.wait(server.fd(), event::in);
+    }
+}
+
+void sys::this_fiber::connect(socket& sock, const socket_address_view& address) {
+    auto& s = current_scheduler();
+    int ret = ::connect(sock.fd(), address.data(), address.size());
+    if (ret == 0) { return; }
+    if (errno != EINPROGRESS && errno != EINTR) { throw bad_call(); }
+    s.wait(sock.fd(), event::out);
+    auto error = sock.get<int>(socket::options::error);
+    if (error != 0) { throw bad_call(std::errc(error)); }
+}
+
+#if defined(UNISTDX_HAVE_SCM_RIGHTS)
+void sys::this_fiber::receive_fds(socket& sock, fd_type* data, size_t n) {
+    auto& s = current_scheduler();
+    char ch = 0;
+    while (::recv(sock.fd(), &ch, 1, MSG_PEEK | MSG_DONTWAIT) == -1) {
+        if (errno == EINTR) { continue; }
+        if (!would_block()) { throw bad_call(); }
+        s.wait(sock.fd(), event::in);
+    }
+    sock.receive_fds(data, n);
+}
+#endif
+
+void sys::this_fiber::sleep_until(fiber_scheduler::clock_type::time_point tp) {
+    current_scheduler().sleep_until(tp);
+}
@@ -0,0 +1,144 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <string>
+#include <vector>
+
+#include <unistdx/io/fiber_io>
+#include <unistdx/io/pipe>
+#include <unistdx/net/socket>
+#include <unistdx/net/unix_socket_address>
+
+#include <unistdx/test/language>
+
+using namespace sys::test::lang;
+
+void test_fiber_io_pipe() {
+    sys::fiber_scheduler sched;
+    sys::pipe pipe;
+    std::string received;
+    sched.emplace([&] () {
+        char buf[4096];
+        ssize_t n;
+        while ((n = sys::this_fiber::read(pipe.in(), buf, sizeof(buf))) != 0) {
+            received.append(buf, n);
+        }
+    });
+    sched.emplace([&] () {
+        // larger than pipe buffer, so that the writer is suspended
+        std::string data(1024*1024, 'x');
+        size_t offset = 0;
+        while (offset != data.size()) {
+            offset += sys::this_fiber::write(pipe.out(), data.data()+offset,
+                                             data.size()-offset);
+        }
+        pipe.out().close();
+    });
+    sched.run();
+    expect(value(1024u*1024u) == value(received.size()));
+}
+
+void test_fiber_io_socket() {
+    sys::unix_socket_address address("\0test_fiber_io_socket");
+    sys::fiber_scheduler sched;
+    sys::socket server(sys::socket_address_family::unix);
+    server.bind(address);
+    server.listen();
+    std::string received;
+    sched.emplace([&] () {
+        sys::socket client;
+        sys::socket_address client_address;
+        sys::this_fiber::accept(server, client, client_address);
+        char buf[16];
+        ssize_t n;
+        while ((n = sys::this_fiber::read(client, buf, sizeof(buf))) != 0) {
+            received.append(buf, n);
+        }
+    });
+    sched.emplace([&] () {
+        sys::socket s(sys::socket_address_family::unix);
+        sys::this_fiber::connect(s, address);
+        sys::this_fiber::write(s, "hello", 5);
+    });
+    sched.run();
+    expect(value(std::string("hello")) == value(received));
+}
+
+#if defined(UNISTDX_HAVE_SCM_RIGHTS)
+void test_fiber_io_receive_fds() {
+    sys::unix_socket_address address("\0test_fiber_io_receive_fds");
+    sys::fiber_scheduler sched;
+    sys::socket server(sys::socket_address_family::unix);
+    server.bind(address);
+    server.listen();
+    sys::fd_type fds[2] = {-1, -1};
+    sched.emplace([&] () {
+        sys::socket client;
+        sys::socket_address client_address;
+        sys::this_fiber::accept(server, client, client_address);
+        sys::this_fiber::receive_fds(client, fds, 2);
+    });
+    sched.emplace([&] () {
+        sys::socket s(sys::socket_address_family::unix);
+        sys::this_fiber::connect(s, address);
+        sys::this_fiber::sleep_for(std::chrono::milliseconds(10));
+        sys::fd_type out[2] = {0, 1};
+        s.send_fds(out, 2);
+    });
+    sched.run();
+    expect(value(fds[0]) > value(2));
+    expect(value(fds[1]) > value(2));
+    sys::fildes f0(fds[0]), f1(fds[1]);
+}
+#endif
+
+void test_fiber_io_sleep() {
+    using namespace std::chrono;
+    sys::fiber_scheduler sched;
+    std::vector<int> order;
+    const auto t0 = steady_clock::now();
+    for (int i=3; i>0; --i) {
+        sched.emplace([&order,i] () {
+            sys::this_fiber::sleep_for(milliseconds(10*i));
+            order.emplace_back(i);
+        });
+    }
+    sched.run();
+    expect(value(std::vector<int>{1,2,3}) == value(order));
+    expect(value(duration_cast<milliseconds>(steady_clock::now()-t0).count()) >= value(30));
+}
+
+void test_fiber_io_outside_scheduler() {
+    sys::pipe pipe;
+    char ch;
+    expect(throws<sys::bad_call>(call([&] () { sys::this_fiber::read(pipe.in(), &ch, 1); })));
+}
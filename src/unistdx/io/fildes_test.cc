@@ -30,7 +30,9 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org/>
 */
 
+#include <algorithm>
 #include <set>
+#include <string>
 
 #include <unistdx/bits/for_each_file_descriptor>
 #include <unistdx/io/fildes>
@@ -100,3 +102,62 @@ void test_fd_type_traits() {
     expect(static_cast<bool>(a));
     expect(no_throw(call([&] () { traits_type::read(a.fd(), buf, 1024); })));
 }
+
+void test_fildes_page_cache() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    sys::fildes f(tmp.path(), sys::open_flag::create | sys::open_flag::read_write, 0644);
+    const sys::offset_type size = 1024*1024;
+    #if defined(UNISTDX_HAVE_FALLOCATE)
+    f.allocate(0, size);
+    expect(value(size) == value(sys::file_status(f.fd()).size()));
+    f.allocate(size, size, sys::allocate_flag::keep_size);
+    expect(value(size) == value(sys::file_status(f.fd()).size()));
+    #else
+    f.truncate(size);
+    #endif
+    std::string data(4096, 'x');
+    f.write(data.data(), data.size());
+    #if defined(UNISTDX_HAVE_SYNC_FILE_RANGE)
+    f.sync_range(0, data.size());
+    f.sync_range(0, 0, sys::sync_range_flag::wait_before |
+                 sys::sync_range_flag::write | sys::sync_range_flag::wait_after);
+    #endif
+    f.advise(sys::file_advice::sequential);
+    f.advise(sys::file_advice::will_need, 0, size);
+    f.advise(sys::file_advice::do_not_need, 0, size);
+    #if defined(UNISTDX_HAVE_READAHEAD)
+    f.read_ahead(0, size);
+    #endif
+    expect(throws<sys::bad_call>(call([&] () {
+        f.advise(sys::file_advice(-1));
+    })));
+}
+
+void test_fildes_positional_io() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    sys::fildes f(tmp.path(), sys::open_flag::create | sys::open_flag::read_write, 0644);
+    const std::string data = "0123456789";
+    expect(value(ssize_t(data.size())) == value(f.pwrite(data.data(), data.size(), 100)));
+    expect(value(0) == value(f.offset()));
+    std::string actual(data.size(), '\0');
+    expect(value(ssize_t(data.size())) == value(f.pread(&actual[0], actual.size(), 100)));
+    expect(value(data) == value(actual));
+    char a[4]{}, b[6]{};
+    sys::io_vector buffers[2]{{a,sizeof(a)},{b,sizeof(b)}};
+    expect(value(10) == value(f.pread(buffers, 2, 100)));
+    expect(value(std::string(a,4)+std::string(b,6)) == value(data));
+    expect(value(10) == value(f.pwrite(buffers, 2, 0)));
+    #if defined(UNISTDX_HAVE_PREADV2) && defined(UNISTDX_HAVE_RWF_NOWAIT)
+    // the data is in the page cache, so the read does not block
+    std::fill_n(a, sizeof(a), 0), std::fill_n(b, sizeof(b), 0);
+    expect(value(10) == value(f.pread(buffers, 2, 0, sys::rw_flag::no_wait)));
+    expect(value(std::string(a,4)+std::string(b,6)) == value(data));
+    // the end of the file is not the same as the data that is not cached
+    expect(value(0) == value(f.pread(buffers, 2, 1000, sys::rw_flag::no_wait)));
+    f.sync_data();
+    f.advise(sys::file_advice::do_not_need);
+    auto ret = f.pread(buffers, 2, 100, sys::rw_flag::no_wait);
+    expect(value(ret == -1 || ret == 10));
+    #endif
+    expect(value(0) == value(f.offset()));
+}
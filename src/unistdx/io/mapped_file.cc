@@ -0,0 +1,185 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/io/mapped_file>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <unistdx/config>
+#include <unistdx/system/resource>
+
+namespace {
+
+    inline size_t
+    round_up(size_t n, size_t page) noexcept {
+        return (n + page - 1) / page * page;
+    }
+
+}
+
+sys::mapped_file_reader::mapped_file_reader(path_view filename, size_t window_size):
+mapped_file_reader(fildes(filename, open_flag::read_only | open_flag::close_on_exec),
+                   window_size) {}
+
+sys::mapped_file_reader::mapped_file_reader(fildes&& fd, size_t window_size):
+_fd(std::move(fd)),
+_file_size(file_status(_fd.fd()).size()),
+_window_size(round_up(std::max(window_size, size_t(1)), page_size())) {}
+
+sys::mapped_file_reader::~mapped_file_reader() noexcept {
+    this->unmap(this->_current);
+    this->unmap(this->_next);
+}
+
+auto
+sys::mapped_file_reader::map(offset_type offset, advise_type advice) -> window {
+    window w;
+    if (offset >= this->_file_size) { return w; }
+    w.size = std::min(this->_window_size, size_t(this->_file_size - offset));
+    w.offset = offset;
+    void* ptr = ::mmap(nullptr, w.size, PROT_READ, MAP_SHARED, this->_fd.fd(), offset);
+    UNISTDX_CHECK2(ptr, MAP_FAILED);
+    w.data = static_cast<char*>(ptr);
+    // the advice is only a hint
+    ::madvise(w.data, w.size, int(advice));
+    return w;
+}
+
+void
+sys::mapped_file_reader::unmap(window& w) noexcept {
+    if (!w.data) { return; }
+    ::madvise(w.data, w.size, MADV_DONTNEED);
+    ::munmap(w.data, w.size);
+    if (this->_drop_cache) {
+        ::posix_fadvise(this->_fd.fd(), w.offset, w.size, POSIX_FADV_DONTNEED);
+    }
+    w = window();
+}
+
+bool
+sys::mapped_file_reader::next() {
+    if (!this->_started) {
+        this->_started = true;
+        this->_current = this->map(0, advise_type::sequential);
+    } else {
+        this->unmap(this->_current);
+        this->_current = this->_next;
+        this->_next = window();
+        if (!this->_current.data) { return false; }
+        ::madvise(this->_current.data, this->_current.size, MADV_SEQUENTIAL);
+    }
+    if (!this->_current.data) { return false; }
+    this->_next = this->map(this->_current.offset + this->_window_size,
+                            advise_type::will_need);
+    return true;
+}
+
+sys::mapped_file_writer::mapped_file_writer(path_view filename, size_t grow_size):
+mapped_file_writer(fildes(filename, open_flag::create | open_flag::truncate |
+                          open_flag::read_write | open_flag::close_on_exec, 0644),
+                   grow_size) {}
+
+sys::mapped_file_writer::mapped_file_writer(fildes&& fd, size_t grow_size):
+_fd(std::move(fd)),
+_size(file_status(_fd.fd()).size()),
+_grow_size(round_up(std::max(grow_size, size_t(1)), page_size())) {}
+
+sys::mapped_file_writer::~mapped_file_writer() noexcept {
+    try {
+        this->close();
+    } catch (...) {
+        // the file is closed anyway
+    }
+}
+
+void
+sys::mapped_file_writer::grow(size_t n) {
+    const auto needed = this->_size + n;
+    if (needed <= this->_capacity) { return; }
+    const auto new_capacity = round_up(std::max(this->_capacity + this->_grow_size, needed),
+                                       page_size());
+    // extend the file first, otherwise the access to the new pages raises SIGBUS
+    #if defined(UNISTDX_HAVE_FALLOCATE)
+    if (::fallocate(this->_fd.fd(), 0, this->_size, new_capacity - this->_size) == -1) {
+        if (errno != EOPNOTSUPP && errno != ENOSYS) { throw bad_call(); }
+        UNISTDX_CHECK(::ftruncate(this->_fd.fd(), new_capacity));
+    }
+    #else
+    UNISTDX_CHECK(::ftruncate(this->_fd.fd(), new_capacity));
+    #endif
+    void* ptr;
+    if (this->_data) {
+        ptr = ::mremap(this->_data, this->_capacity, new_capacity, MREMAP_MAYMOVE);
+    } else {
+        ptr = ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     this->_fd.fd(), 0);
+    }
+    UNISTDX_CHECK2(ptr, MAP_FAILED);
+    this->_data = static_cast<char*>(ptr);
+    this->_capacity = new_capacity;
+}
+
+char*
+sys::mapped_file_writer::reserve(size_t n) {
+    this->grow(n);
+    return this->_data + this->_size;
+}
+
+void
+sys::mapped_file_writer::write(const void* data, size_t n) {
+    if (n == 0) { return; }
+    std::memcpy(this->reserve(n), data, n);
+    this->commit(n);
+}
+
+void
+sys::mapped_file_writer::sync(sync_flag flags) {
+    if (!this->_data) { return; }
+    UNISTDX_CHECK(::msync(this->_data, this->_capacity, int(flags)));
+}
+
+void
+sys::mapped_file_writer::close() {
+    if (!this->_fd) { return; }
+    if (this->_data) {
+        auto data = this->_data;
+        this->_data = nullptr;
+        UNISTDX_CHECK(::munmap(data, this->_capacity));
+        this->_capacity = 0;
+        UNISTDX_CHECK(::ftruncate(this->_fd.fd(), this->_size));
+    }
+    this->_fd.close();
+}
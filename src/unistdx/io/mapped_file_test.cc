@@ -0,0 +1,109 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <unistdx/fs/file_status>
+#include <unistdx/io/mapped_file>
+#include <unistdx/system/resource>
+
+#include <unistdx/test/language>
+#include <unistdx/test/random_string>
+#include <unistdx/test/temporary_file>
+
+using namespace sys::test::lang;
+
+void test_mapped_file_reader() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    const auto page = sys::page_size();
+    for (size_t size : {size_t(0), size_t(1), page, 3*page + page/2}) {
+        std::string expected = test::random_string<char>(size);
+        { std::ofstream{tmp.path()} << expected; }
+        sys::mapped_file_reader reader(tmp.path(), page);
+        reader.drop_cache(true);
+        expect(value(page) == value(reader.window_size()));
+        expect(value(sys::offset_type(size)) == value(reader.file_size()));
+        std::string actual;
+        size_t nwindows = 0;
+        while (reader.next()) {
+            expect(value(sys::offset_type(actual.size())) == value(reader.offset()));
+            expect(value(reader.size() <= page));
+            actual.append(reader.data(), reader.size());
+            ++nwindows;
+        }
+        expect(value((size + page - 1)/page) == value(nwindows));
+        expect(value(expected) == value(actual));
+        expect(!value(reader.next()));
+    }
+}
+
+void test_mapped_file_writer() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    const auto page = sys::page_size();
+    std::string expected;
+    {
+        sys::mapped_file_writer writer(tmp.path(), page);
+        for (size_t i=0; i<100; ++i) {
+            auto chunk = test::random_string<char>(i*37 % 1000);
+            writer.write(chunk.data(), chunk.size());
+            expected += chunk;
+        }
+        auto* ptr = writer.reserve(3);
+        std::memcpy(ptr, "xyz", 3);
+        writer.commit(3);
+        expected += "xyz";
+        expect(value(expected.size()) == value(writer.size()));
+        expect(value(writer.capacity() >= writer.size()));
+        expect(value(0u) == value(writer.capacity() % page));
+        expect(value(expected) == value(std::string(writer.data(), writer.size())));
+        writer.sync();
+    }
+    std::stringstream actual;
+    actual << std::ifstream(tmp.path()).rdbuf();
+    expect(value(expected) == value(actual.str()));
+    // append to the existing file
+    {
+        sys::fildes fd(tmp.path(), sys::open_flag::read_write);
+        sys::mapped_file_writer writer(std::move(fd));
+        expect(value(expected.size()) == value(writer.size()));
+        writer.write("abc", 3);
+        expected += "abc";
+        writer.close();
+    }
+    expect(value(sys::offset_type(expected.size())) == value(sys::file_status(tmp.path()).size()));
+    std::stringstream actual2;
+    actual2 << std::ifstream(tmp.path()).rdbuf();
+    expect(value(expected) == value(actual2.str()));
+}
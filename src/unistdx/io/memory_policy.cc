@@ -0,0 +1,148 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include <unistdx/base/check>
+#include <unistdx/bits/mman>
+#include <unistdx/io/memory_policy>
+#include <unistdx/system/call>
+
+namespace {
+
+    inline size_t round_up(size_t size, size_t alignment) noexcept {
+        return ((size + alignment - 1) / alignment) * alignment;
+    }
+
+}
+
+#if defined(UNISTDX_HAVE_LINUX_MEMPOLICY_H)
+void sys::memory_policy::bind(void* data, size_t size) const {
+    if (!data || size == 0) { return; }
+    const auto* mask = this->_mode == memory_policy_mode::normal ? nullptr : this->_nodes.get();
+    const unsigned long max_node = mask ? this->_nodes.size() : 0;
+    check(call(calls::mbind, data, size, int(this->_mode), mask, max_node, 0U));
+}
+
+void sys::memory_policy::apply() const {
+    const auto* mask = this->_mode == memory_policy_mode::normal ? nullptr : this->_nodes.get();
+    const unsigned long max_node = mask ? this->_nodes.size() : 0;
+    check(call(calls::set_mempolicy, int(this->_mode), mask, max_node));
+}
+
+auto sys::memory_policy::local(const static_cpu_set& cpus) -> memory_policy {
+    return bind(nodes_of(cpus));
+}
+
+sys::node_set sys::nodes_of(const static_cpu_set& cpus) {
+    node_set online, result;
+    {
+        std::ifstream in("/sys/devices/system/node/online");
+        in >> online;
+        if (online.count() == 0) { online.set(0); }
+    }
+    char path[100];
+    const auto n = online.size();
+    for (int node=0; node<n; ++node) {
+        if (!online[node]) { continue; }
+        std::sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+        std::ifstream in(path);
+        static_cpu_set node_cpus;
+        in >> node_cpus;
+        if ((node_cpus & cpus).count() != 0) { result.set(node); }
+    }
+    // node CPU lists are not available (non-NUMA kernel or a container)
+    if (result.count() == 0) { result = online; }
+    return result;
+}
+#endif
+
+size_t sys::huge_page_size() {
+    std::ifstream in("/proc/meminfo");
+    std::string name;
+    size_t size = 0;
+    while (in >> name) {
+        if (name == "Hugepagesize:") {
+            if (in >> size) { return size*1024; }
+            break;
+        }
+        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return size_t(2)*1024*1024;
+}
+
+auto sys::placement_allocator::reallocate(value_type* data, size_type old_size,
+                                          size_type new_size) -> value_type* {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (this->_huge_pages == huge_page_policy::hugetlb) {
+        #if defined(UNISTDX_HAVE_MAP_HUGETLB)
+        flags |= MAP_HUGETLB;
+        #endif
+        const auto page = huge_page_size();
+        old_size = round_up(old_size, page);
+        new_size = round_up(new_size, page);
+    }
+    value_type* result = nullptr;
+    if (new_size == 0) {
+        if (data && old_size) { check(::munmap(data, old_size)); }
+        return nullptr;
+    } else if (old_size == new_size) {
+        return data;
+    } else if (old_size == 0 || this->_huge_pages == huge_page_policy::hugetlb) {
+        result = static_cast<value_type*>(check(::mmap(
+            nullptr, new_size, PROT_READ | PROT_WRITE, flags, -1, 0), MAP_FAILED));
+    } else {
+        result = static_cast<value_type*>(
+            check(::mremap(data, old_size, new_size, MREMAP_MAYMOVE), MAP_FAILED));
+    }
+    #if defined(UNISTDX_HAVE_MADV_HUGEPAGE)
+    if (this->_huge_pages == huge_page_policy::transparent) {
+        check(::madvise(result, new_size, MADV_HUGEPAGE));
+    }
+    #endif
+    #if defined(UNISTDX_HAVE_LINUX_MEMPOLICY_H)
+    // pages that were already touched stay where they are
+    if (this->_policy.mode() != memory_policy_mode::normal) {
+        this->_policy.bind(result, new_size);
+    }
+    #endif
+    if (this->_huge_pages == huge_page_policy::hugetlb && old_size != 0) {
+        std::memcpy(result, data, std::min(old_size, new_size));
+        check(::munmap(data, old_size));
+    }
+    return result;
+}
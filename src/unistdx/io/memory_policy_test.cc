@@ -0,0 +1,79 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <sstream>
+
+#include <unistdx/io/memory_policy>
+#include <unistdx/ipc/process>
+#include <unistdx/test/language>
+
+using namespace sys::test::lang;
+
+void test_node_set_io() {
+    sys::node_set nodes{0,1,2,3,5};
+    expect(value(nodes.count()) == value(5));
+    std::stringstream tmp;
+    tmp << nodes;
+    expect(value(tmp.str()) == value("0-3,5"));
+    sys::node_set nodes2;
+    tmp >> nodes2;
+    expect(value(nodes2) == value(nodes));
+}
+
+void write_and_grow(sys::byte_buffer& buffer) {
+    const int n = 10000;
+    for (int i=0; i<n; ++i) { buffer.write(i); }
+    buffer.flip();
+    for (int i=0; i<n; ++i) {
+        int j = -1;
+        buffer.read(j);
+        expect(value(j) == value(i));
+    }
+}
+
+void test_placement_allocator_transparent_huge_pages() {
+    sys::byte_buffer buffer{4096,
+        sys::make_placement_allocator(sys::huge_page_policy::transparent)};
+    write_and_grow(buffer);
+}
+
+void test_memory_policy_local() {
+    auto nodes = sys::nodes_of(sys::this_process::cpu_affinity());
+    expect(value(nodes.count()) > value(0));
+    auto policy = sys::memory_policy::local(sys::this_process::cpu_affinity());
+    expect(value(policy.nodes()) == value(nodes));
+    sys::byte_buffer buffer{4096, sys::make_placement_allocator(policy)};
+    write_and_grow(buffer);
+    sys::memory_ptr<int> ptr{sys::page_flag::read|sys::page_flag::write,
+                             sys::map_flag::anonymous|sys::map_flag::priv, 0};
+    sys::memory_policy::interleave(nodes).bind(ptr);
+}
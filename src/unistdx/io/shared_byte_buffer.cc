@@ -39,6 +39,12 @@ For more information, please refer to <http://unlicense.org/>
 auto sys::memory_file_allocator::reallocate(value_type* data, size_type old_size,
                                             size_type new_size) -> value_type* {
     this->_file_descriptor.truncate(new_size);
+    return remap(data, old_size, new_size);
+}
+
+auto sys::memory_file_allocator::remap(value_type* data, size_type old_size,
+                                       size_type new_size) -> value_type* {
+    if (old_size == new_size) { return data; }
     value_type* result = nullptr;
     if (new_size == 0) {
         if (data && old_size) { sys::check(::munmap(data, old_size)); }
@@ -64,7 +64,8 @@ void test_shared_byte_buffer_grow() {
         std::lock_guard<sys::futex> lock(mtx);
         buffer.copy_in();
         std::clog << "buffer.size()=" << buffer.size() << std::endl;
-        return buffer.size() == 2*4096 ? 0 : 1;
+        std::clog << "buffer.stats().remaps=" << buffer.stats().remaps << std::endl;
+        return buffer.size() == 2*4096 && buffer.stats().remaps == 1 ? 0 : 1;
     }};
     {
         notifier.read();
@@ -85,6 +86,30 @@ void test_shared_byte_buffer_grow() {
     expect(value(status.exit_code()) == value(0));
 }
 
+void test_shared_byte_buffer_no_remap_without_resize() {
+    auto parent = sys::shared_byte_buffer::make_parent_page();
+    sys::shared_byte_buffer buffer{parent.view(), 4096};
+    for (int i=0; i<10; ++i) {
+        auto g = buffer.guard();
+        buffer.write(i);
+    }
+    expect(value(buffer.stats().copy_ins) == value(10u));
+    expect(value(buffer.stats().remaps) == value(0u));
+    expect(value(buffer.size()) == value(4096u));
+    expect(value(buffer.child()->size) == value(4096u));
+    const auto generation = buffer.child()->generation;
+    {
+        auto g = buffer.guard();
+        buffer.grow();
+    }
+    expect(value(buffer.child()->size) == value(2u*4096u));
+    expect(value(buffer.child()->generation) == value(generation+1));
+    {
+        auto g = buffer.guard();
+    }
+    expect(value(buffer.stats().remaps) == value(0u));
+}
+
 struct datum {
     int i;
     std::string s;
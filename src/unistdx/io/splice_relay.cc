@@ -0,0 +1,167 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/io/splice_relay>
+
+#if defined(UNISTDX_HAVE_SPLICE)
+
+#include <fcntl.h>
+
+#include <algorithm>
+
+#include <unistdx/base/check>
+
+namespace {
+
+    constexpr const unsigned int splice_flags = 0
+        #if defined(UNISTDX_HAVE_SPLICE_F_NONBLOCK)
+        | SPLICE_F_NONBLOCK
+        #endif
+        #if defined(UNISTDX_HAVE_SPLICE_F_MOVE)
+        | SPLICE_F_MOVE
+        #endif
+        ;
+
+    inline size_t
+    check_splice(ssize_t ret) {
+        if (ret == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { return 0; }
+            throw sys::bad_call();
+        }
+        return static_cast<size_t>(ret);
+    }
+
+}
+
+sys::splice_relay::splice_relay(size_t capacity) {
+    #if defined(UNISTDX_HAVE_F_SETPIPE_SZ)
+    if (capacity != 0) {
+        this->_pipe.out().pipe_buffer_size(static_cast<int>(capacity));
+    }
+    #endif
+    #if defined(UNISTDX_HAVE_F_GETPIPE_SZ)
+    this->_capacity = this->_pipe.out().pipe_buffer_size();
+    #else
+    this->_capacity = capacity == 0 ? 65536 : capacity;
+    #endif
+}
+
+size_t
+sys::splice_relay::fill(fildes& in) {
+    if (!wants_read()) { return 0; }
+    ssize_t ret = ::splice(in.fd(), nullptr, this->_pipe.out().fd(), nullptr,
+                           this->_capacity - this->_buffered, splice_flags);
+    if (ret == 0) { this->_eof = true; }
+    auto n = check_splice(ret);
+    this->_buffered += n;
+    return n;
+}
+
+size_t
+sys::splice_relay::drain(fildes& out, size_t n) {
+    if (n == 0) { return 0; }
+    n = check_splice(::splice(this->_pipe.in().fd(), nullptr, out.fd(), nullptr,
+                              n, splice_flags));
+    this->_buffered -= n;
+    return n;
+}
+
+size_t
+sys::splice_relay::operator()(fildes& in, fildes& out) {
+    size_t nwritten = 0;
+    while (true) {
+        auto n = fill(in);
+        auto m = drain(out, this->_buffered);
+        #if defined(UNISTDX_HAVE_TEE)
+        this->_teed -= std::min(this->_teed, m);
+        #endif
+        nwritten += m;
+        if (n == 0 && m == 0) { break; }
+    }
+    return nwritten;
+}
+
+#if defined(UNISTDX_HAVE_TEE)
+size_t
+sys::splice_relay::drain_mirror(fildes& mirror) {
+    if (this->_mirror_buffered == 0) { return 0; }
+    auto n = check_splice(::splice(this->_mirror_pipe.in().fd(), nullptr,
+                                   mirror.fd(), nullptr,
+                                   this->_mirror_buffered, splice_flags));
+    this->_mirror_buffered -= n;
+    return n;
+}
+
+size_t
+sys::splice_relay::operator()(fildes& in, fildes& out, fildes& mirror) {
+    if (!this->_mirror_pipe.in()) { this->_mirror_pipe.open(); }
+    size_t nwritten = 0;
+    while (true) {
+        auto n = fill(in);
+        // tee always duplicates the data from the beginning of the pipe,
+        // so the next portion is duplicated only when the previous one
+        // has been written to the destination
+        size_t nteed = 0;
+        if (this->_teed == 0 && this->_buffered != 0) {
+            nteed = check_splice(::tee(this->_pipe.in().fd(),
+                                       this->_mirror_pipe.out().fd(),
+                                       this->_buffered, splice_flags));
+            this->_teed = nteed;
+            this->_mirror_buffered += nteed;
+        }
+        auto m = drain(out, this->_teed);
+        this->_teed -= m;
+        auto k = drain_mirror(mirror);
+        nwritten += m;
+        if (n == 0 && nteed == 0 && m == 0 && k == 0) { break; }
+    }
+    return nwritten;
+}
+#endif
+
+#if defined(UNISTDX_HAVE_VMSPLICE)
+size_t
+sys::splice_relay::gift(const io_vector* buffers, size_t n) {
+    unsigned int flags = 0;
+    #if defined(UNISTDX_HAVE_SPLICE_F_GIFT)
+    flags |= SPLICE_F_GIFT;
+    #endif
+    #if defined(UNISTDX_HAVE_SPLICE_F_NONBLOCK)
+    flags |= SPLICE_F_NONBLOCK;
+    #endif
+    auto m = check_splice(::vmsplice(this->_pipe.out().fd(), buffers, n, flags));
+    this->_buffered += m;
+    return m;
+}
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <algorithm>
+#include <string>
+
+#include <unistdx/base/byte_buffer>
+#include <unistdx/io/pipe>
+#include <unistdx/io/splice_relay>
+
+#include <unistdx/test/language>
+#include <unistdx/test/operator>
+
+using namespace sys::test::lang;
+
+#if defined(UNISTDX_HAVE_SPLICE)
+namespace {
+
+    std::string make_pattern(size_t n) {
+        std::string s(n, ' ');
+        for (size_t i=0; i<n; ++i) { s[i] = char('a' + i%26); }
+        return s;
+    }
+
+    void read_all(sys::fildes& in, std::string& out) {
+        char buf[4096];
+        ssize_t n;
+        while ((n = in.read(buf, sizeof(buf))) > 0) { out.append(buf, n); }
+    }
+
+}
+
+void test_splice_relay() {
+    const auto expected = make_pattern(200000);
+    sys::pipe source, sink;
+    sys::splice_relay relay;
+    expect(value(relay.capacity() > 0));
+    std::string actual;
+    size_t nwritten = 0;
+    while (!relay.finished()) {
+        if (nwritten != expected.size()) {
+            nwritten += source.out().write(expected.data()+nwritten,
+                                           expected.size()-nwritten);
+            if (nwritten == expected.size()) { source.out().close(); }
+        }
+        relay(source.in(), sink.out());
+        read_all(sink.in(), actual);
+    }
+    read_all(sink.in(), actual);
+    expect(value(expected.size()) == value(actual.size()));
+    expect(value(expected == actual));
+    expect(!value(relay.wants_read()));
+    expect(!value(relay.wants_write()));
+}
+
+#if defined(UNISTDX_HAVE_TEE)
+void test_splice_relay_mirror() {
+    const auto expected = make_pattern(200000);
+    sys::pipe source, sink, mirror;
+    sys::splice_relay relay;
+    std::string actual, mirrored;
+    size_t nwritten = 0;
+    while (!relay.finished()) {
+        if (nwritten != expected.size()) {
+            nwritten += source.out().write(expected.data()+nwritten,
+                                           expected.size()-nwritten);
+            if (nwritten == expected.size()) { source.out().close(); }
+        }
+        relay(source.in(), sink.out(), mirror.out());
+        read_all(sink.in(), actual);
+        read_all(mirror.in(), mirrored);
+    }
+    read_all(sink.in(), actual);
+    read_all(mirror.in(), mirrored);
+    expect(value(expected == actual));
+    expect(value(expected == mirrored));
+}
+#endif
+
+#if defined(UNISTDX_HAVE_VMSPLICE)
+void test_splice_relay_gift() {
+    const auto expected = make_pattern(4096*4);
+    sys::byte_buffer buffer(expected.size());
+    std::copy(expected.begin(), expected.end(), buffer.data());
+    sys::pipe source, sink;
+    source.out().close();
+    sys::splice_relay relay;
+    sys::io_vector v(buffer.data(), buffer.size());
+    expect(value(expected.size()) == value(relay.gift(&v, 1)));
+    expect(value(expected.size()) == value(relay.buffered()));
+    std::string actual;
+    while (!relay.finished()) {
+        relay(source.in(), sink.out());
+        read_all(sink.in(), actual);
+    }
+    expect(value(expected == actual));
+}
+#endif
+#endif
@@ -0,0 +1,95 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/io/write_behind>
+
+#include <unistdx/config>
+
+sys::write_behind::write_behind(fildes& fd, offset_type window_size,
+                                offset_type offset):
+_fd(fd),
+_window_size(window_size > 0 ? window_size : 1),
+_offset(offset),
+_submitted(offset),
+_dropped(offset) {}
+
+void
+sys::write_behind::advance(size_t n) {
+    this->_offset += n;
+    auto& fd = this->_fd;
+    while (this->_offset - this->_submitted >= this->_window_size) {
+        const auto window = this->_submitted;
+        #if defined(UNISTDX_HAVE_SYNC_FILE_RANGE)
+        // start write-out of the current window
+        fd.sync_range(window, this->_window_size, sync_range_flag::write);
+        #endif
+        this->_submitted += this->_window_size;
+        // wait for the previous windows and drop them from the page cache
+        if (this->_dropped < window) {
+            #if defined(UNISTDX_HAVE_SYNC_FILE_RANGE)
+            fd.sync_range(this->_dropped, window - this->_dropped,
+                          sync_range_flag::wait_before | sync_range_flag::write |
+                          sync_range_flag::wait_after);
+            #else
+            fd.sync_data();
+            #endif
+            fd.advise(file_advice::do_not_need, this->_dropped, window - this->_dropped);
+            this->_dropped = window;
+        }
+    }
+}
+
+void
+sys::write_behind::write(const void* data, size_t n) {
+    const char* first = static_cast<const char*>(data);
+    auto& fd = this->_fd;
+    while (n != 0) {
+        auto m = fd.write(first, n);
+        first += m, n -= m;
+        this->advance(m);
+    }
+}
+
+void
+sys::write_behind::flush() {
+    if (this->_dropped == this->_offset) { return; }
+    auto& fd = this->_fd;
+    #if defined(UNISTDX_HAVE_SYNC_FILE_RANGE)
+    fd.sync_range(this->_dropped, this->_offset - this->_dropped,
+                  sync_range_flag::wait_before | sync_range_flag::write |
+                  sync_range_flag::wait_after);
+    #else
+    fd.sync_data();
+    #endif
+    fd.advise(file_advice::do_not_need, this->_dropped, this->_offset - this->_dropped);
+    this->_dropped = this->_submitted = this->_offset;
+}
@@ -0,0 +1,65 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <string>
+
+#include <unistdx/fs/file_status>
+#include <unistdx/io/write_behind>
+
+#include <unistdx/test/language>
+#include <unistdx/test/random_string>
+#include <unistdx/test/temporary_file>
+
+using namespace sys::test::lang;
+
+void test_write_behind() {
+    test::temporary_file tmp(UNISTDX_TMPFILE);
+    sys::fildes f(tmp.path(), sys::open_flag::create | sys::open_flag::truncate |
+                  sys::open_flag::read_write, 0644);
+    sys::write_behind writer(f, 4096);
+    expect(value(4096) == value(writer.window_size()));
+    std::string expected;
+    for (int i=0; i<100; ++i) {
+        auto chunk = test::random_string<char>(i*131 % 3000);
+        writer.write(chunk.data(), chunk.size());
+        expected += chunk;
+    }
+    writer.flush();
+    writer.flush();
+    expect(value(sys::offset_type(expected.size())) == value(writer.offset()));
+    expect(value(sys::offset_type(expected.size())) == value(sys::file_status(f.fd()).size()));
+    std::string actual(expected.size(), '\0');
+    f.offset(0);
+    size_t n = 0;
+    while (n != actual.size()) { n += f.read(&actual[n], actual.size()-n); }
+    expect(value(expected) == value(actual));
+}
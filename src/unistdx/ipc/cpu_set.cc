@@ -131,6 +131,20 @@ sys::static_cpu_set sys::static_cpu_set::all() noexcept {
     return result;
 }
 
+std::ostream& sys::operator<<(std::ostream& out, const node_set& rhs) {
+    return cpu_set_write(out, rhs);
+}
+
+std::istream& sys::operator>>(std::istream& in, node_set& rhs) {
+    return cpu_set_read(in, rhs, [&rhs] (int node) { return node<rhs.size(); });
+}
+
+auto sys::node_set::count() const noexcept -> size_type {
+    size_type cnt{};
+    for (auto x : this->_data) { cnt += bit_count(x); }
+    return cnt;
+}
+
 std::ostream& sys::operator<<(std::ostream& out, const dynamic_cpu_set& rhs) {
     return cpu_set_write(out, rhs);
 }
@@ -0,0 +1,372 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <ucontext.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+#include <unistdx/base/check>
+#include <unistdx/bits/mman>
+#include <unistdx/ipc/fiber>
+#include <unistdx/system/resource>
+
+namespace {
+
+    thread_local sys::fiber* current_fiber = nullptr;
+    thread_local sys::fiber_scheduler* current_scheduler = nullptr;
+
+    struct no_lock {
+        inline void lock() noexcept {}
+        inline void unlock() noexcept {}
+    };
+
+    class scheduler_guard {
+
+    private:
+        sys::fiber_scheduler* _old;
+
+    public:
+        inline explicit scheduler_guard(sys::fiber_scheduler* s) noexcept:
+        _old(current_scheduler) { current_scheduler = s; }
+        inline ~scheduler_guard() noexcept { current_scheduler = this->_old; }
+
+    };
+
+    template <class Timer>
+    inline bool
+    later(const Timer& a, const Timer& b) noexcept {
+        return a.first > b.first;
+    }
+
+}
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define UNISTDX_FIBER_ASM
+
+/*
+Context switch that saves callee-saved registers on the current stack,
+stores stack pointer in *from and restores registers from the stack \p to.
+New fibers start in unistdx_fiber_start which calls the function from
+the second callee-saved register with the first one as the argument.
+*/
+extern "C" void unistdx_fiber_switch(void** from, void* to) noexcept;
+extern "C" void unistdx_fiber_start() noexcept;
+
+#if defined(__x86_64__)
+asm(R"(
+    .pushsection .text
+    .globl unistdx_fiber_switch
+    .hidden unistdx_fiber_switch
+    .type unistdx_fiber_switch,@function
+    .align 16
+unistdx_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size unistdx_fiber_switch,.-unistdx_fiber_switch
+
+    .globl unistdx_fiber_start
+    .hidden unistdx_fiber_start
+    .type unistdx_fiber_start,@function
+    .align 16
+unistdx_fiber_start:
+    .cfi_startproc
+    .cfi_undefined rip
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .cfi_endproc
+    .size unistdx_fiber_start,.-unistdx_fiber_start
+    .popsection
+)");
+#elif defined(__aarch64__)
+asm(R"(
+    .pushsection .text
+    .globl unistdx_fiber_switch
+    .hidden unistdx_fiber_switch
+    .type unistdx_fiber_switch,%function
+    .align 4
+unistdx_fiber_switch:
+    sub sp, sp, #176
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mrs x9, fpcr
+    str x9, [sp, #160]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    ldr x9, [sp, #160]
+    msr fpcr, x9
+    add sp, sp, #176
+    ret
+    .size unistdx_fiber_switch,.-unistdx_fiber_switch
+
+    .globl unistdx_fiber_start
+    .hidden unistdx_fiber_start
+    .type unistdx_fiber_start,%function
+    .align 4
+unistdx_fiber_start:
+    .cfi_startproc
+    .cfi_undefined x30
+    mov x0, x19
+    blr x20
+    brk #0
+    .cfi_endproc
+    .size unistdx_fiber_start,.-unistdx_fiber_start
+    .popsection
+)");
+#endif
+
+#else
+
+namespace {
+
+    void unistdx_fiber_switch(void** from, void* to) noexcept {
+        ::ucontext_t self;
+        *from = &self;
+        ::swapcontext(&self, static_cast<::ucontext_t*>(to));
+    }
+
+}
+
+#endif
+
+sys::fiber_stack::fiber_stack(size_t size) {
+    const auto page = page_size();
+    this->_size = (size + page - 1)/page*page + page;
+    this->_data = static_cast<char*>(check(::mmap(
+        nullptr, this->_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK | MAP_NORESERVE, -1, 0), MAP_FAILED));
+    if (::mprotect(this->_data, page, PROT_NONE) == -1) {
+        bad_call err;
+        ::munmap(this->_data, this->_size);
+        throw err;
+    }
+}
+
+sys::fiber_stack::~fiber_stack() {
+    if (this->_data) { ::munmap(this->_data, this->_size); }
+}
+
+size_t sys::fiber_stack::size() const noexcept {
+    return this->_size == 0 ? 0 : this->_size - page_size();
+}
+
+sys::fiber::fiber(function_type func, fiber_stack&& stack):
+_stack(std::move(stack)), _function(std::move(func)) {
+    if (!this->_stack) { throw bad_call(std::errc::invalid_argument); }
+    auto top = reinterpret_cast<std::uintptr_t>(this->_stack.top()) & ~std::uintptr_t(15);
+    #if defined(__x86_64__)
+    // mxcsr/fpu control word, r15, r14, r13, r12, rbx, rbp, return address
+    auto frame = reinterpret_cast<std::uintptr_t*>(top) - 8;
+    frame[0] = (std::uintptr_t(0x037f) << 32) | std::uintptr_t(0x1f80);
+    frame[1] = 0;
+    frame[2] = 0;
+    frame[3] = reinterpret_cast<std::uintptr_t>(&fiber::main);
+    frame[4] = reinterpret_cast<std::uintptr_t>(this);
+    frame[5] = 0;
+    frame[6] = 0;
+    frame[7] = reinterpret_cast<std::uintptr_t>(&unistdx_fiber_start);
+    this->_context = frame;
+    #elif defined(__aarch64__)
+    // x19-x30, d8-d15, fpcr
+    auto frame = reinterpret_cast<std::uintptr_t*>(top) - 22;
+    std::fill_n(frame, 22, std::uintptr_t(0));
+    frame[0] = reinterpret_cast<std::uintptr_t>(this);
+    frame[1] = reinterpret_cast<std::uintptr_t>(&fiber::main);
+    frame[11] = reinterpret_cast<std::uintptr_t>(&unistdx_fiber_start);
+    this->_context = frame;
+    #else
+    auto ctx = reinterpret_cast<::ucontext_t*>(
+        (top - sizeof(::ucontext_t)) & ~std::uintptr_t(15));
+    check(::getcontext(ctx));
+    ctx->uc_link = nullptr;
+    ctx->uc_stack.ss_sp = static_cast<char*>(this->_stack.top()) - this->_stack.size();
+    ctx->uc_stack.ss_size = reinterpret_cast<char*>(ctx) -
+        static_cast<char*>(ctx->uc_stack.ss_sp);
+    ::makecontext(ctx, [] () { fiber::main(current_fiber); }, 0);
+    this->_context = ctx;
+    #endif
+}
+
+void sys::fiber::main(fiber* f) noexcept {
+    try {
+        f->_function();
+    } catch (...) {
+        f->_exception = std::current_exception();
+    }
+    f->_function = nullptr;
+    f->_done = true;
+    unistdx_fiber_switch(&f->_context, f->_caller);
+}
+
+void sys::fiber::resume() {
+    if (this->_done) { return; }
+    auto prev = current_fiber;
+    current_fiber = this;
+    unistdx_fiber_switch(&this->_caller, this->_context);
+    current_fiber = prev;
+    if (this->_exception) {
+        std::exception_ptr ptr;
+        std::swap(ptr, this->_exception);
+        std::rethrow_exception(ptr);
+    }
+}
+
+sys::fiber* sys::this_fiber::get() noexcept { return current_fiber; }
+
+void sys::this_fiber::yield() noexcept {
+    auto f = current_fiber;
+    if (!f) { return; }
+    unistdx_fiber_switch(&f->_context, f->_caller);
+}
+
+void sys::fiber_scheduler::emplace(fiber::function_type func) {
+    this->_fibers.emplace_back(std::move(func), this->_stacks.allocate());
+    this->_ready.emplace_back(std::prev(this->_fibers.end()));
+}
+
+sys::fiber_scheduler* sys::this_fiber::scheduler() noexcept { return current_scheduler; }
+
+void sys::fiber_scheduler::wait(fd_type fd, event ev) {
+    if (!this_fiber::get()) { throw bad_call(std::errc::operation_not_permitted); }
+    if (fd < 0) { throw bad_call(std::errc::bad_file_descriptor); }
+    const auto idx = static_cast<size_t>(fd);
+    if (idx >= this->_waiting.size()) { this->_waiting.resize(idx+1, this->_fibers.end()); }
+    if (this->_waiting[idx] != this->_fibers.end()) {
+        throw bad_call(std::errc::device_or_resource_busy);
+    }
+    this->_poller.emplace(fd, ev);
+    this->_waiting[idx] = this->_current;
+    ++this->_nwaiting;
+    this->_suspended = true;
+    this_fiber::yield();
+    this->_poller.erase(fd);
+}
+
+void sys::fiber_scheduler::sleep_until(clock_type::time_point tp) {
+    if (!this_fiber::get()) { throw bad_call(std::errc::operation_not_permitted); }
+    this->_timers.emplace_back(tp, this->_current);
+    std::push_heap(this->_timers.begin(), this->_timers.end(), later<timer>);
+    this->_suspended = true;
+    this_fiber::yield();
+}
+
+void sys::fiber_scheduler::run() {
+    using namespace std::chrono;
+    scheduler_guard g(this);
+    no_lock lock;
+    while (!this->_fibers.empty()) {
+        while (!this->_ready.empty()) {
+            auto f = this->_ready.front();
+            this->_ready.pop_front();
+            this->_current = f;
+            this->_suspended = false;
+            try {
+                f->resume();
+            } catch (...) {
+                this->_fibers.erase(f);
+                throw;
+            }
+            if (f->done()) {
+                this->_stacks.deallocate(f->release_stack());
+                this->_fibers.erase(f);
+            } else if (!this->_suspended) {
+                this->_ready.emplace_back(f);
+            }
+        }
+        if (this->_nwaiting == 0 && this->_timers.empty()) { break; }
+        if (this->_timers.empty()) {
+            this->_poller.wait(lock);
+        } else {
+            // round up to not wake up before the timer expires
+            const auto dt = this->_timers.front().first - clock_type::now();
+            const auto ms = std::max(
+                duration_cast<milliseconds>(dt + milliseconds(1) - clock_type::duration(1)),
+                milliseconds::zero());
+            this->_poller.wait_for(lock, ms);
+        }
+        for (const auto& ev : this->_poller) {
+            const auto idx = static_cast<size_t>(ev.fd());
+            if (idx >= this->_waiting.size()) { continue; }
+            auto& result = this->_waiting[idx];
+            if (result == this->_fibers.end()) { continue; }
+            this->_ready.emplace_back(result);
+            result = this->_fibers.end();
+            --this->_nwaiting;
+        }
+        const auto now = clock_type::now();
+        while (!this->_timers.empty() && this->_timers.front().first <= now) {
+            std::pop_heap(this->_timers.begin(), this->_timers.end(), later<timer>);
+            this->_ready.emplace_back(this->_timers.back().second);
+            this->_timers.pop_back();
+        }
+    }
+}
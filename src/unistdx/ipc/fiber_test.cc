@@ -0,0 +1,150 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistdx/io/pipe>
+#include <unistdx/ipc/fiber>
+#include <unistdx/test/language>
+
+using namespace sys::test::lang;
+
+void test_fiber_yield() {
+    std::vector<int> trace;
+    sys::fiber f([&trace] () {
+        expect(value(sys::this_fiber::get()) != value(nullptr));
+        trace.emplace_back(1);
+        sys::this_fiber::yield();
+        trace.emplace_back(3);
+    });
+    expect(value(sys::this_fiber::get()) == value(nullptr));
+    f.resume();
+    trace.emplace_back(2);
+    expect(!value(f.done()));
+    f.resume();
+    expect(value(f.done()));
+    f.resume();
+    expect(value(std::vector<int>{1,2,3}) == value(trace));
+    expect(value(bool(f.release_stack())));
+}
+
+void test_fiber_nested() {
+    std::string trace;
+    sys::fiber outer([&trace] () {
+        trace += 'a';
+        sys::fiber inner([&trace] () {
+            trace += 'b';
+            sys::this_fiber::yield();
+            trace += 'd';
+        });
+        inner.resume();
+        trace += 'c';
+        sys::this_fiber::yield();
+        inner.resume();
+        trace += 'e';
+    });
+    outer.resume();
+    expect(value(std::string("abc")) == value(trace));
+    outer.resume();
+    expect(value(std::string("abcde")) == value(trace));
+    expect(value(outer.done()));
+}
+
+void test_fiber_exception() {
+    sys::fiber f([] () {
+        sys::this_fiber::yield();
+        throw std::runtime_error("fiber");
+    });
+    f.resume();
+    try {
+        f.resume();
+        expect(false);
+    } catch (const std::runtime_error& err) {
+        expect(value(std::string("fiber")) == value(std::string(err.what())));
+    }
+    expect(value(f.done()));
+}
+
+void test_fiber_floating_point() {
+    double result = 0;
+    sys::fiber f([&result] () {
+        volatile double x = 1.5;
+        sys::this_fiber::yield();
+        result = x*x;
+    });
+    f.resume();
+    volatile double y = 2.5;
+    f.resume();
+    expect(value(2.25) == value(result));
+    expect(value(2.5) == value(double(y)));
+}
+
+void test_fiber_stack_pool() {
+    sys::fiber_stack_pool pool(4096*4, 1);
+    auto s1 = pool.allocate();
+    auto s2 = pool.allocate();
+    expect(value(s1.size()) >= value(4096u*4u));
+    auto top = s1.top();
+    pool.deallocate(std::move(s1));
+    pool.deallocate(std::move(s2));
+    expect(value(1u) == value(pool.size()));
+    auto s3 = pool.allocate();
+    expect(value(top) == value(s3.top()));
+    expect(value(0u) == value(pool.size()));
+}
+
+void test_fiber_scheduler() {
+    sys::fiber_scheduler sched;
+    sys::pipe pipe;
+    std::string received;
+    sched.emplace([&] () {
+        char buf[16];
+        while (received.size() != 5) {
+            auto n = pipe.in().read(buf, sizeof(buf));
+            if (n == 0) { sched.wait(pipe.in().fd(), sys::event::in); continue; }
+            received.append(buf, n);
+        }
+    });
+    sched.emplace([&] () {
+        for (char ch : std::string("hello")) {
+            pipe.out().write(&ch, 1);
+            sys::this_fiber::yield();
+        }
+    });
+    expect(value(2u) == value(sched.size()));
+    sched.run();
+    expect(value(std::string("hello")) == value(received));
+    expect(value(0u) == value(sched.size()));
+    expect(value(2u) == value(sched.stacks().size()));
+}
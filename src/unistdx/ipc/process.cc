@@ -32,8 +32,10 @@ For more information, please refer to <http://unlicense.org/>
 
 #include <limits.h>
 
+#include <unistdx/io/poller>
 #include <unistdx/ipc/identity>
 #include <unistdx/ipc/process>
+#include <unistdx/system/call>
 #include <unistdx/system/resource>
 
 sys::fildes sys::this_process::get_namespace(const char* suffix) {
@@ -89,3 +91,23 @@ sys::dynamic_cpu_set sys::process_view::cpus() const {
     check(ret);
     return mask;
 }
+
+void sys::process::open_pidfd() {
+    if (this->_pidfd) { return; }
+    #if defined(SYS_pidfd_open)
+    fd_type fd;
+    UNISTDX_CHECK(fd = fd_type(call(calls::pidfd_open, this->_pid, 0)));
+    this->_pidfd = fildes(fd);
+    #else
+    throw bad_call(std::errc::not_supported);
+    #endif
+}
+
+void sys::event_poller::emplace(process& child) {
+    child.open_pidfd();
+    emplace(child.pidfd().fd(), event::in);
+}
+
+void sys::event_poller::erase(const process& child) {
+    erase(child.pidfd().fd());
+}
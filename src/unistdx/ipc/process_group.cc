@@ -30,14 +30,97 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org/>
 */
 
+#include <poll.h>
+
+#include <limits>
+#include <thread>
+
 #include <unistdx/ipc/process_group>
 
+namespace {
+
+    inline int
+    exit_mask(const sys::process_status& status) {
+        return status.exit_code() | sys::signal_type(status.term_signal());
+    }
+
+}
+
 int
 sys::process_group::wait() {
     int ret = 0;
-    for (auto& p : this->_procs) {
-        auto x = p.wait();
-        ret |= x.exit_code() | signal_type(x.term_signal());
+    sys::siginfo_type info;
+    for (auto n = this->_procs.size(); n != 0; --n) {
+        UNISTDX_CHECK(::waitid(P_PGID, this->_id, &info, int(wait_flags::exited)));
+        ret |= exit_mask(sys::process_status(info));
+    }
+    return ret;
+}
+
+auto
+sys::process_group::reap(process_status& status, wait_flags flags) -> iterator {
+    sys::siginfo_type info{};
+    UNISTDX_CHECK(::waitid(P_PGID, this->_id, &info, int(flags)));
+    status = sys::process_status(info);
+    if (status.pid() == 0) { return this->_procs.end(); }
+    return std::find_if(
+        this->_procs.begin(), this->_procs.end(),
+        [&status] (const process& p) { return p.id() == status.pid(); }
+    );
+}
+
+sys::process_status
+sys::process_group::wait_next(wait_flags flags) {
+    sys::process_status status;
+    while (!this->_procs.empty()) {
+        auto result = this->reap(status, flags);
+        if (status.pid() == 0) { break; }
+        if (result != this->_procs.end()) {
+            this->_procs.erase(result);
+            break;
+        }
+    }
+    return status;
+}
+
+void
+sys::process_group::sleep(std::chrono::nanoseconds timeout) {
+    using namespace std::chrono;
+    std::vector<::pollfd> fds;
+    fds.reserve(this->_procs.size());
+    try {
+        for (auto& p : this->_procs) {
+            p.open_pidfd();
+            fds.push_back(::pollfd{p.pidfd().fd(), POLLIN, 0});
+        }
+    } catch (const bad_call& err) {
+        // no process file descriptors: poll with small delay
+        if (err.errc() != std::errc::function_not_supported &&
+            err.errc() != std::errc::not_supported) {
+            throw;
+        }
+        std::this_thread::sleep_for(std::min(timeout, nanoseconds(milliseconds(1))));
+        return;
+    }
+    auto ms = duration_cast<milliseconds>(timeout + milliseconds(1) - nanoseconds(1)).count();
+    if (ms > std::numeric_limits<int>::max()) { ms = std::numeric_limits<int>::max(); }
+    int ret = ::poll(fds.data(), fds.size(), int(ms));
+    if (ret == -1 && errno != EINTR) { throw bad_call(); }
+}
+
+int
+sys::process_group::terminate_and_wait(std::chrono::nanoseconds grace) {
+    int ret = 0;
+    if (this->_procs.empty()) { return ret; }
+    auto callback = [&ret] (const process&, const process_status& status) {
+        ret |= exit_mask(status);
+    };
+    this->send(signal::terminate);
+    if (!this->wait_for(callback, grace)) {
+        this->send(signal::kill);
+        while (!this->_procs.empty()) {
+            ret |= exit_mask(this->wait_next());
+        }
     }
     return ret;
 }
@@ -31,7 +31,9 @@ For more information, please refer to <http://unlicense.org/>
 */
 
 #include <mutex>
+#include <vector>
 
+#include <unistdx/io/pipe>
 #include <unistdx/ipc/process_group>
 #include <unistdx/test/config>
 #include <unistdx/test/operator>
@@ -71,3 +73,70 @@ void test_process_group_wait_sync() {
     int ret = g.wait();
     expect(value(0) == value(ret));
 }
+
+void test_process_group_wait_next() {
+    UNISTDX_SKIP_IF_RUNNING_ON_VALGRIND();
+    sys::pipe pipe;
+    pipe.in().unsetf(sys::open_flag::non_blocking);
+    sys::process_group g;
+    g.emplace([&pipe] () {
+        char ch;
+        pipe.in().read(&ch, 1);
+        return 1;
+    });
+    g.emplace([] () { return 2; });
+    g.emplace([] () { return 3; });
+    std::vector<int> codes;
+    for (int i=0; i<2; ++i) { codes.emplace_back(g.wait_next().exit_code()); }
+    std::sort(codes.begin(), codes.end());
+    expect(value(std::vector<int>{2,3}) == value(codes));
+    expect(value(1u) == value(g.size()));
+    expect(value(0) == value(g.wait_next(sys::wait_flags::exited |
+                                        sys::wait_flags::non_blocking).pid()));
+    pipe.out().write("x", 1);
+    expect(value(1) == value(g.wait_next().exit_code()));
+    expect(g.empty());
+    expect(value(0) == value(g.wait_next().pid()));
+}
+
+void test_process_group_wait_for() {
+    UNISTDX_SKIP_IF_RUNNING_ON_VALGRIND();
+    sys::pipe pipe;
+    pipe.in().unsetf(sys::open_flag::non_blocking);
+    sys::process_group g;
+    g.emplace([&pipe] () {
+        char ch;
+        pipe.in().read(&ch, 1);
+        return 1;
+    });
+    g.emplace([] () { return 2; });
+    std::vector<int> codes;
+    auto callback = [&codes] (const sys::process&, sys::process_status status) {
+        codes.emplace_back(status.exit_code());
+    };
+    expect(!value(g.wait_for(callback, std::chrono::milliseconds(100))));
+    expect(value(std::vector<int>{2}) == value(codes));
+    pipe.out().write("x", 1);
+    expect(value(g.wait_for(callback, std::chrono::seconds(10))));
+    expect(value(std::vector<int>{2,1}) == value(codes));
+}
+
+void test_process_group_terminate_and_wait() {
+    UNISTDX_SKIP_IF_RUNNING_ON_VALGRIND();
+    sys::pipe pipe;
+    pipe.in().unsetf(sys::open_flag::non_blocking);
+    sys::process_group g;
+    for (int i=0; i<2; ++i) {
+        g.emplace([&pipe,i] () {
+            if (i == 1) { sys::this_process::ignore_signal(sys::signal::terminate); }
+            pipe.out().write("x", 1);
+            while (true) { ::pause(); }
+            return 0;
+        });
+    }
+    char ch;
+    for (int i=0; i<2; ++i) { pipe.in().read(&ch, 1); }
+    int ret = g.terminate_and_wait(std::chrono::milliseconds(100));
+    expect(value(int(SIGTERM) | int(SIGKILL)) == value(ret));
+    expect(g.empty());
+}
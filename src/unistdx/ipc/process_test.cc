@@ -31,10 +31,14 @@ For more information, please refer to <http://unlicense.org/>
 */
 
 #include <bitset>
+#include <chrono>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include <unistdx/base/log_message>
 #include <unistdx/io/pipe>
+#include <unistdx/io/poller>
 #include <unistdx/ipc/argstream>
 #include <unistdx/ipc/execute>
 #include <unistdx/ipc/identity>
@@ -223,6 +227,55 @@ void test_process_as_thread() {
 }
 #endif
 
+#if defined(UNISTDX_HAVE_CLONE_PIDFD)
+void test_process_try_wait() {
+    using pf = sys::process_flag;
+    sys::pipe pipe;
+    pipe.in().unsetf(sys::open_flag::non_blocking);
+    sys::process child{[&pipe] () {
+        char ch;
+        pipe.in().read(&ch, 1);
+        return 7;
+    }, pf::signal_parent | pf::pidfd};
+    expect(value(bool(child.pidfd())));
+    expect(value(child.try_wait().pid()) == value(0));
+    pipe.out().write("x", 1);
+    auto status = child.wait();
+    expect(value(status.exited()));
+    expect(value(7) == value(status.exit_code()));
+}
+#endif
+
+void test_process_event_poller() {
+    UNISTDX_SKIP_IF_RUNNING_ON_VALGRIND();
+    const int n = 3;
+    std::vector<sys::process> children;
+    for (int i=0; i<n; ++i) {
+        children.emplace_back([i] () {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10*(n-i)));
+            return i;
+        });
+    }
+    sys::event_poller poller;
+    for (auto& child : children) { poller.emplace(child); }
+    std::mutex mtx;
+    std::unique_lock<std::mutex> lock(mtx);
+    std::bitset<n> exited;
+    while (exited.count() != n) {
+        poller.wait(lock);
+        for (const auto& ev : poller) {
+            for (auto& child : children) {
+                if (ev.fd() != child.pidfd().fd()) { continue; }
+                auto status = child.try_wait();
+                if (status.pid() == 0) { continue; }
+                expect(value(status.exited()));
+                exited.set(status.exit_code());
+                poller.erase(child);
+            }
+        }
+    }
+}
+
 template <class Set>
 void do_test_cpu_set() {
     expect(value("") == value(test::stream_insert(Set{})));
@@ -31,7 +31,11 @@ For more information, please refer to <http://unlicense.org/>
 */
 
 #include <unistdx/ipc/signal>
+#include <unistdx/ipc/signal_file_descriptor>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <ostream>
 
 const char* sys::to_string(signal rhs) noexcept {
@@ -83,3 +87,70 @@ std::ostream&
 sys::operator<<(std::ostream& out, const signal rhs) {
     return out << to_string(rhs) << '(' << signal_type(rhs) << ')';
 }
+
+#if defined(UNISTDX_HAVE_SIGNALFD)
+namespace {
+
+    void
+    copy(const ::signalfd_siginfo& from, sys::signal_information& to) noexcept {
+        std::memset(&to, 0, sizeof(sys::signal_information));
+        to.si_signo = int(from.ssi_signo);
+        to.si_errno = from.ssi_errno;
+        to.si_code = from.ssi_code;
+        switch (from.ssi_signo) {
+            case SIGCHLD:
+                to.si_pid = sys::pid_type(from.ssi_pid);
+                to.si_uid = sys::uid_type(from.ssi_uid);
+                to.si_status = from.ssi_status;
+                to.si_utime = clock_t(from.ssi_utime);
+                to.si_stime = clock_t(from.ssi_stime);
+                break;
+            case SIGSEGV:
+            case SIGBUS:
+            case SIGILL:
+            case SIGFPE:
+            case SIGTRAP:
+                to.si_addr = reinterpret_cast<void*>(std::uintptr_t(from.ssi_addr));
+                break;
+            case SIGIO:
+                to.si_band = from.ssi_band;
+                to.si_fd = from.ssi_fd;
+                break;
+            default:
+                #if defined(SI_TIMER)
+                if (from.ssi_code == SI_TIMER) {
+                    to.si_timerid = int(from.ssi_tid);
+                    to.si_overrun = int(from.ssi_overrun);
+                } else
+                #endif
+                {
+                    to.si_pid = sys::pid_type(from.ssi_pid);
+                    to.si_uid = sys::uid_type(from.ssi_uid);
+                }
+                to.si_value.sival_ptr = reinterpret_cast<void*>(std::uintptr_t(from.ssi_ptr));
+                break;
+        }
+    }
+
+}
+
+size_t
+sys::signal_file_descriptor::read(signal_information* data, size_t n) {
+    constexpr const size_t max_signals = 64;
+    ::signalfd_siginfo buffer[max_signals];
+    // only non-blocking descriptor can be read again without waiting for new signals
+    const bool non_blocking = n > max_signals &&
+        (this->flags() & open_flag::non_blocking) == open_flag::non_blocking;
+    size_t nread = 0;
+    while (nread != n) {
+        const auto m = std::min(n-nread, max_signals);
+        auto ret = ::read(fd(), buffer, m*sizeof(::signalfd_siginfo));
+        UNISTDX_CHECK_IO(ret);
+        const auto k = size_t(ret) / sizeof(::signalfd_siginfo);
+        for (size_t i=0; i<k; ++i) { copy(buffer[i], data[nread+i]); }
+        nread += k;
+        if (k != m || !non_blocking) { break; }
+    }
+    return nread;
+}
+#endif
@@ -30,8 +30,15 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org/>
 */
 
+#include <signal.h>
+#include <unistd.h>
+
+#include <mutex>
+
+#include <unistdx/io/poller>
 #include <unistdx/ipc/process>
 #include <unistdx/ipc/signal>
+#include <unistdx/ipc/signal_file_descriptor>
 
 #include <unistdx/test/exception>
 #include <unistdx/test/operator>
@@ -83,3 +90,74 @@ void test_signal_bind_bad_signal() {
         bind_signal(sys::signal(-1), catch_sigaction)
     );
 }
+
+void test_signal_set() {
+    using s = sys::signal;
+    sys::signal_set signals{s::user_defined_1, s::child};
+    expect(value(signals.contains(s::child)));
+    expect(!value(signals.contains(s::terminate)));
+    signals.insert(s::terminate);
+    signals.erase(s::child);
+    expect(value(signals.contains(s::terminate)));
+    expect(!value(signals.contains(s::child)));
+}
+
+#if defined(UNISTDX_HAVE_SIGNALFD)
+void test_signal_file_descriptor() {
+    // run in a separate single-threaded process, otherwise
+    // the signals may be delivered to other threads of the test process
+    sys::process outer([] () {
+        using s = sys::signal;
+        sys::signal_set signals{s::user_defined_1, s::user_defined_2, s::child};
+        sys::signal_guard g(signals);
+        sys::signal_file_descriptor sfd(signals);
+        sys::signal_information info[8];
+        if (sfd.read(info, 8) != 0) { return 1; }
+        sys::event_poller poller;
+        poller.emplace(sfd.fd(), sys::event::in);
+        sys::this_process::send(s::user_defined_1);
+        sys::this_process::send(s::user_defined_2);
+        std::mutex mtx;
+        std::unique_lock<std::mutex> lock(mtx);
+        poller.wait(lock);
+        auto n = sfd.read(info, 8);
+        if (n != 2) { return 2; }
+        if (info[0].signal() != s::user_defined_1) { return 3; }
+        if (info[1].signal() != s::user_defined_2) { return 4; }
+        if (info[0].process_id() != sys::this_process::id()) { return 5; }
+        sys::process child([] () { return 3; });
+        n = 0;
+        while (n == 0) {
+            poller.wait(lock);
+            n = sfd.read(info, 8);
+        }
+        if (n != 1) { return 6; }
+        if (info[0].signal() != s::child) { return 7; }
+        if (info[0].process_id() != child.id()) { return 8; }
+        if (info[0].exit_code() != 3) { return 9; }
+        if (child.wait().exit_code() != 3) { return 10; }
+        return 0;
+    });
+    expect(value(0) == value(outer.wait().exit_code()));
+}
+
+void test_signal_file_descriptor_blocking_batch() {
+    sys::process outer([] () {
+        const auto rt = sys::signal(SIGRTMIN);
+        sys::signal_set signals{rt};
+        sys::signal_guard g(signals);
+        sys::signal_file_descriptor sfd(signals, sys::signal_file_descriptor::flag::close_on_exec);
+        // real-time signals are queued, exactly one batch is pending
+        for (int i=0; i<64; ++i) {
+            ::sigval value{};
+            if (::sigqueue(sys::this_process::id(), SIGRTMIN, value) == -1) { return 1; }
+        }
+        // the default action terminates the process if the read blocks
+        ::alarm(10);
+        sys::signal_information info[100];
+        if (sfd.read(info, 100) != 64) { return 2; }
+        return 0;
+    });
+    expect(value(0) == value(outer.wait().exit_code()));
+}
+#endif
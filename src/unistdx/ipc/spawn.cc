@@ -0,0 +1,247 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <unistdx/ipc/spawn>
+#include <unistdx/system/call>
+
+namespace {
+
+    class signal_blocker {
+
+    private:
+        ::sigset_t _old;
+
+    public:
+        inline signal_blocker() noexcept {
+            ::sigset_t all;
+            ::sigfillset(&all);
+            ::pthread_sigmask(SIG_SETMASK, &all, &this->_old);
+        }
+        inline ~signal_blocker() noexcept {
+            ::pthread_sigmask(SIG_SETMASK, &this->_old, nullptr);
+        }
+        inline const ::sigset_t& old_mask() const noexcept { return this->_old; }
+
+    };
+
+    struct child_arguments {
+        char* const* argv;
+        char* const* envp;
+        const sys::spawn_options* options;
+        const ::sigset_t* mask;
+        volatile int error;
+    };
+
+    // Runs in the memory of the parent process: only async-signal-safe calls
+    // are allowed, nothing is allocated and nothing is modified except the error.
+    int child_main(void* ptr) {
+        auto* args = static_cast<child_arguments*>(ptr);
+        const auto& options = *args->options;
+        // handlers of the parent must not run in the shared memory
+        struct ::sigaction dfl{};
+        dfl.sa_handler = SIG_DFL;
+        for (int i=1; i<_NSIG; ++i) {
+            struct ::sigaction old{};
+            if (::sigaction(i, nullptr, &old) == 0 && old.sa_handler != SIG_IGN &&
+                old.sa_handler != SIG_DFL) {
+                ::sigaction(i, &dfl, nullptr);
+            }
+        }
+        ::pthread_sigmask(SIG_SETMASK, args->mask, nullptr);
+        if (options.process_group() != -1 && ::setpgid(0, options.process_group()) == -1) {
+            goto fail;
+        }
+        for (const auto& pair : options.files()) {
+            if (pair.second < 0) {
+                if (::close(pair.first) == -1) { goto fail; }
+            } else if (pair.first == pair.second) {
+                int flags = ::fcntl(pair.first, F_GETFD);
+                if (flags == -1 || ::fcntl(pair.first, F_SETFD, flags & ~FD_CLOEXEC) == -1) {
+                    goto fail;
+                }
+            } else if (::dup2(pair.first, pair.second) == -1) {
+                goto fail;
+            }
+        }
+        if (options.directory() && ::chdir(options.directory()) == -1) { goto fail; }
+        if (options.search_path()) {
+            ::execvpe(args->argv[0], args->argv, args->envp);
+        } else {
+            ::execve(args->argv[0], args->argv, args->envp);
+        }
+    fail:
+        args->error = errno;
+        ::_exit(127);
+    }
+
+    void reap(sys::pid_type pid) noexcept {
+        int status = 0;
+        while (::waitpid(pid, &status, 0) == -1 && errno == EINTR) {}
+    }
+
+    // The child is not reaped yet, so its process ID can not be reused.
+    sys::fildes open_pidfd(sys::pid_type pid) {
+        #if defined(SYS_pidfd_open)
+        int fd = int(sys::call(sys::calls::pidfd_open, pid, 0));
+        if (fd == -1) {
+            int error = errno;
+            ::kill(pid, SIGKILL);
+            reap(pid);
+            throw sys::bad_call(std::errc(error));
+        }
+        return sys::fildes(fd);
+        #else
+        ::kill(pid, SIGKILL);
+        reap(pid);
+        throw sys::bad_call(std::errc::not_supported);
+        #endif
+    }
+
+    sys::process spawn_clone(char* const argv[], char* const envp[],
+                             const sys::spawn_options& options) {
+        using namespace sys;
+        #if defined(UNISTDX_HAVE_CLONE)
+        // the parent is suspended until the child calls exec,
+        // hence the child may use the stack of the parent
+        alignas(16) char stack[4096*8];
+        signal_blocker blocker;
+        child_arguments args{argv, envp, &options, &blocker.old_mask(), 0};
+        int flags = CLONE_VM | CLONE_VFORK | SIGCHLD;
+        int pidfd = -1;
+        #if defined(UNISTDX_HAVE_CLONE_PIDFD)
+        if (options.pidfd()) { flags |= CLONE_PIDFD; }
+        #endif
+        pid_type pid = ::clone(child_main, stack + sizeof(stack), flags, &args, &pidfd);
+        if (pid == -1) { throw bad_call(); }
+        if (args.error != 0) {
+            if (pidfd != -1) { ::close(pidfd); }
+            reap(pid);
+            throw bad_call(std::errc(args.error));
+        }
+        #if !defined(UNISTDX_HAVE_CLONE_PIDFD)
+        if (options.pidfd()) { return process(pid, open_pidfd(pid)); }
+        #endif
+        return process(pid, fildes(pidfd));
+        #else
+        throw bad_call(std::errc::not_supported);
+        #endif
+    }
+
+    #define UNISTDX_SPAWN_CHECK(...) \
+        if ((ret = __VA_ARGS__) != 0) { throw sys::bad_call(std::errc(ret)); }
+
+    sys::process spawn_posix(char* const argv[], char* const envp[],
+                             const sys::spawn_options& options) {
+        using namespace sys;
+        #if defined(UNISTDX_HAVE_POSIX_SPAWN)
+        struct file_actions {
+            ::posix_spawn_file_actions_t actions;
+            file_actions() { ::posix_spawn_file_actions_init(&actions); }
+            ~file_actions() { ::posix_spawn_file_actions_destroy(&actions); }
+        } files;
+        struct attributes {
+            ::posix_spawnattr_t attrs;
+            attributes() { ::posix_spawnattr_init(&attrs); }
+            ~attributes() { ::posix_spawnattr_destroy(&attrs); }
+        } attrs;
+        int ret = 0;
+        for (const auto& pair : options.files()) {
+            if (pair.second < 0) {
+                UNISTDX_SPAWN_CHECK(::posix_spawn_file_actions_addclose(
+                    &files.actions, pair.first));
+            } else {
+                UNISTDX_SPAWN_CHECK(::posix_spawn_file_actions_adddup2(
+                    &files.actions, pair.first, pair.second));
+            }
+        }
+        if (options.directory()) {
+            #if defined(UNISTDX_HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP)
+            UNISTDX_SPAWN_CHECK(::posix_spawn_file_actions_addchdir_np(
+                &files.actions, options.directory()));
+            #else
+            throw bad_call(std::errc::not_supported);
+            #endif
+        }
+        short flags = POSIX_SPAWN_SETSIGDEF;
+        // reset only the signals with handlers, ignored signals stay ignored
+        // as with the other methods
+        ::sigset_t handled;
+        ::sigemptyset(&handled);
+        for (int i=1; i<_NSIG; ++i) {
+            struct ::sigaction old{};
+            if (::sigaction(i, nullptr, &old) == 0 && old.sa_handler != SIG_IGN &&
+                old.sa_handler != SIG_DFL) {
+                ::sigaddset(&handled, i);
+            }
+        }
+        UNISTDX_SPAWN_CHECK(::posix_spawnattr_setsigdefault(&attrs.attrs, &handled));
+        if (options.process_group() != -1) {
+            flags |= POSIX_SPAWN_SETPGROUP;
+            UNISTDX_SPAWN_CHECK(::posix_spawnattr_setpgroup(
+                &attrs.attrs, options.process_group()));
+        }
+        UNISTDX_SPAWN_CHECK(::posix_spawnattr_setflags(&attrs.attrs, flags));
+        pid_type pid = -1;
+        if (options.search_path()) {
+            UNISTDX_SPAWN_CHECK(::posix_spawnp(&pid, argv[0], &files.actions,
+                                               &attrs.attrs, argv, envp));
+        } else {
+            UNISTDX_SPAWN_CHECK(::posix_spawn(&pid, argv[0], &files.actions,
+                                              &attrs.attrs, argv, envp));
+        }
+        return options.pidfd() ? process(pid, open_pidfd(pid)) : process(pid, fildes());
+        #else
+        throw bad_call(std::errc::not_supported);
+        #endif
+    }
+
+    #undef UNISTDX_SPAWN_CHECK
+
+}
+
+sys::process sys::spawn(char* const argv[], char* const envp[], const spawn_options& options) {
+    #if defined(UNISTDX_FORK_MUTEX)
+    bits::global_lock_type lock(bits::fork_mutex);
+    #endif
+    switch (options.method()) {
+        case spawn_method::posix_spawn: return spawn_posix(argv, envp, options);
+        case spawn_method::clone:
+        default: return spawn_clone(argv, envp, options);
+    }
+}
@@ -0,0 +1,128 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <csignal>
+#include <string>
+
+#include <unistdx/io/pipe>
+#include <unistdx/ipc/spawn>
+#include <unistdx/test/language>
+
+using namespace sys::test::lang;
+
+namespace {
+
+    sys::argstream shell(const char* script) {
+        sys::argstream args;
+        args.append("/bin/sh");
+        args.append("-c");
+        args.append(script);
+        return args;
+    }
+
+    const sys::spawn_method all_methods[] = {
+        sys::spawn_method::clone,
+        sys::spawn_method::posix_spawn,
+    };
+
+}
+
+void test_spawn_exit_code() {
+    for (auto method : all_methods) {
+        auto child = sys::spawn(shell("exit 3"), sys::spawn_options().method(method));
+        auto status = child.wait();
+        expect(value(status.exited()));
+        expect(value(status.exit_code()) == value(3));
+    }
+}
+
+void test_spawn_redirect() {
+    for (auto method : all_methods) {
+        sys::pipe p;
+        sys::spawn_options options;
+        options.method(method).dup(p.out().fd(), STDOUT_FILENO).close(p.in().fd());
+        auto child = sys::spawn(shell("echo hello"), options);
+        // the output fits into the pipe buffer
+        expect(value(child.wait().exit_code()) == value(0));
+        p.out().close();
+        std::string output;
+        char buf[64];
+        ssize_t n;
+        while ((n = ::read(p.in().fd(), buf, sizeof(buf))) > 0) { output.append(buf, n); }
+        expect(value(output) == value("hello\n"));
+    }
+}
+
+void test_spawn_search_path_and_directory() {
+    for (auto method : all_methods) {
+        sys::pipe p;
+        sys::argstream args;
+        args.append("pwd");
+        sys::spawn_options options;
+        options.method(method).search_path(true).directory("/")
+            .dup(p.out().fd(), STDOUT_FILENO);
+        auto child = sys::spawn(args, options);
+        expect(value(child.wait().exit_code()) == value(0));
+        p.out().close();
+        char buf[64]{};
+        auto n = ::read(p.in().fd(), buf, sizeof(buf));
+        expect(value(std::string(buf, n > 0 ? n : 0)) == value("/\n"));
+    }
+}
+
+void test_spawn_errors() {
+    sys::argstream args;
+    args.append("/non-existent-file");
+    for (auto method : all_methods) {
+        expect(throws<sys::bad_call>(call([&] () {
+            sys::spawn(args, sys::spawn_options().method(method));
+        })));
+    }
+}
+
+void test_spawn_pidfd() {
+    auto child = sys::spawn(shell("exit 0"), sys::spawn_options().pidfd(true));
+    expect(value(bool(child.pidfd())));
+    expect(value(child.wait().exit_code()) == value(0));
+}
+
+void test_spawn_keeps_ignored_signals() {
+    auto old = ::signal(SIGUSR1, SIG_IGN);
+    for (auto method : all_methods) {
+        auto child = sys::spawn(shell("kill -USR1 $$; exit 0"),
+                                sys::spawn_options().method(method));
+        auto status = child.wait();
+        expect(value(status.exited()));
+        expect(value(status.exit_code()) == value(0));
+    }
+    ::signal(SIGUSR1, old);
+}
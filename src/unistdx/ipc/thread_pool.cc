@@ -0,0 +1,203 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <linux/futex.h>
+
+#include <algorithm>
+#include <limits>
+
+#include <unistdx/base/bad_call>
+#include <unistdx/ipc/process>
+#include <unistdx/ipc/thread_pool>
+#include <unistdx/system/call>
+#include <unistdx/system/topology>
+
+namespace {
+
+    thread_local const sys::thread_pool* current_pool = nullptr;
+    thread_local int current_worker_index = -1;
+
+}
+
+class sys::thread_pool::worker {
+
+public:
+    work_stealing_deque<task_ptr> tasks;
+    std::vector<worker*> victims;
+    std::thread thread;
+    int index = -1;
+    int cpu = -1;
+
+};
+
+sys::thread_pool::thread_pool(unsigned num_threads) {
+    start(std::vector<int>(std::max(num_threads, 1u), -1));
+}
+
+sys::thread_pool::thread_pool(const static_cpu_set& cpus) {
+    std::vector<int> tmp;
+    const auto n = cpus.size();
+    for (int i=0; i<n; ++i) { if (cpus[i]) { tmp.emplace_back(i); } }
+    if (tmp.empty()) { tmp.emplace_back(-1); }
+    start(tmp);
+}
+
+sys::thread_pool::~thread_pool() {
+    stop();
+    join();
+    for (auto* t : this->_queue) { delete t; }
+}
+
+void sys::thread_pool::start(const std::vector<int>& cpus) {
+    // report CPUs that the workers can not be pinned to before starting the threads
+    const auto allowed = this_process::cpu_affinity();
+    for (auto cpu : cpus) {
+        if (cpu != -1 && !allowed[cpu]) { throw bad_call(std::errc::invalid_argument); }
+    }
+    const int n = cpus.size();
+    for (int i=0; i<n; ++i) {
+        this->_workers.emplace_back(new worker);
+        auto& w = *this->_workers.back();
+        w.index = i;
+        w.cpu = cpus[i];
+    }
+    static_cpu_set pinned;
+    for (auto cpu : cpus) { if (cpu != -1) { pinned.set(cpu); } }
+    // steal from the workers on the nearest CPUs first:
+    // SMT siblings, then CPUs that share a cache, then the same package and node
+    const cpu_topology topology(pinned);
+    auto distance = [&topology] (int a, int b) {
+        return a == -1 || b == -1 ? 0 : topology.distance(a, b);
+    };
+    for (auto& w : this->_workers) {
+        for (int i=1; i<n; ++i) {
+            w->victims.emplace_back(this->_workers[(w->index+i)%n].get());
+        }
+        auto cpu = w->cpu;
+        std::stable_sort(w->victims.begin(), w->victims.end(),
+                         [cpu,&distance] (const worker* a, const worker* b) {
+                             return distance(cpu, a->cpu) < distance(cpu, b->cpu);
+                         });
+    }
+    for (auto& w : this->_workers) {
+        auto* ptr = w.get();
+        w->thread = std::thread([this,ptr] () { loop(*ptr); });
+    }
+}
+
+void sys::thread_pool::submit(task t) {
+    auto* ptr = new task(std::move(t));
+    if (current_pool == this) {
+        this->_workers[current_worker_index]->tasks.push(ptr);
+    } else {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_queue.emplace_back(ptr);
+    }
+    notify_one();
+}
+
+void sys::thread_pool::stop() {
+    this->_stopped = true;
+    notify_all();
+}
+
+void sys::thread_pool::join() {
+    for (auto& w : this->_workers) {
+        if (w->thread.joinable()) { w->thread.join(); }
+    }
+}
+
+int sys::thread_pool::current_worker() noexcept { return current_worker_index; }
+
+auto sys::thread_pool::next_task(worker& w) -> task_ptr {
+    if (auto* t = w.tasks.pop()) { return t; }
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (!this->_queue.empty()) {
+            auto* t = this->_queue.front();
+            this->_queue.pop_front();
+            return t;
+        }
+    }
+    for (auto* victim : w.victims) {
+        if (auto* t = victim->tasks.steal()) { return t; }
+    }
+    return nullptr;
+}
+
+void sys::thread_pool::loop(worker& w) {
+    current_pool = this;
+    current_worker_index = w.index;
+    if (w.cpu != -1) {
+        try {
+            this_process::cpu_affinity(static_cpu_set{w.cpu});
+        } catch (const bad_call&) {
+            // the CPU went offline after the check, run unpinned
+        }
+    }
+    while (true) {
+        if (auto* t = next_task(w)) {
+            std::unique_ptr<task> ptr(t);
+            (*t)();
+            continue;
+        }
+        const auto epoch = this->_epoch.load(std::memory_order_seq_cst);
+        this->_num_sleeping.fetch_add(1, std::memory_order_seq_cst);
+        if (auto* t = next_task(w)) {
+            this->_num_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+            std::unique_ptr<task> ptr(t);
+            (*t)();
+            continue;
+        }
+        if (this->_stopped) {
+            this->_num_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+            break;
+        }
+        call(calls::futex, &this->_epoch, FUTEX_WAIT_PRIVATE, epoch, nullptr, nullptr, 0);
+        this->_num_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+    }
+    current_pool = nullptr;
+    current_worker_index = -1;
+}
+
+void sys::thread_pool::notify_one() {
+    this->_epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (this->_num_sleeping.load(std::memory_order_seq_cst) > 0) {
+        call(calls::futex, &this->_epoch, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+}
+
+void sys::thread_pool::notify_all() {
+    this->_epoch.fetch_add(1, std::memory_order_seq_cst);
+    call(calls::futex, &this->_epoch, FUTEX_WAKE_PRIVATE, std::numeric_limits<int>::max(),
+         nullptr, nullptr, 0);
+}
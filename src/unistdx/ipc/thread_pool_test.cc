@@ -0,0 +1,138 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <unistdx/ipc/process>
+#include <unistdx/ipc/thread_pool>
+#include <unistdx/test/language>
+
+using namespace sys::test::lang;
+
+void test_work_stealing_deque_owner() {
+    sys::work_stealing_deque<int*> deque(2);
+    std::vector<int> values{1,2,3,4,5,6,7,8,9,10};
+    for (auto& x : values) { deque.push(&x); }
+    expect(value(deque.size()) == value(10));
+    expect(value(*deque.steal()) == value(1));
+    expect(value(*deque.pop()) == value(10));
+    expect(value(*deque.pop()) == value(9));
+    expect(value(deque.size()) == value(7));
+    while (deque.pop()) {}
+    expect(value(deque.empty()));
+    expect(value(deque.steal() == nullptr));
+}
+
+void test_work_stealing_deque_thieves() {
+    constexpr const int n = 10000;
+    sys::work_stealing_deque<int*> deque;
+    std::vector<int> values(n, 0);
+    std::atomic<int> count{0};
+    std::atomic<bool> stopped{false};
+    std::vector<std::thread> thieves;
+    for (int i=0; i<3; ++i) {
+        thieves.emplace_back([&] () {
+            while (!stopped || !deque.empty()) {
+                if (auto* x = deque.steal()) { ++*x; ++count; }
+            }
+        });
+    }
+    for (int i=0; i<n; ++i) {
+        deque.push(&values[i]);
+        if (i % 3 == 0) { if (auto* y = deque.pop()) { ++*y; ++count; } }
+    }
+    while (auto* x = deque.pop()) { ++*x; ++count; }
+    stopped = true;
+    for (auto& t : thieves) { t.join(); }
+    expect(value(count.load()) == value(n));
+    int num_ones = 0;
+    for (auto x : values) { if (x == 1) { ++num_ones; } }
+    expect(value(num_ones) == value(n));
+}
+
+void test_thread_pool_nested_tasks() {
+    std::atomic<int> count{0};
+    {
+        sys::thread_pool pool(4);
+        expect(value(pool.size()) == value(4u));
+        expect(value(sys::thread_pool::current_worker()) == value(-1));
+        for (int i=0; i<100; ++i) {
+            pool.submit([&pool,&count] () {
+                ++count;
+                for (int j=0; j<10; ++j) {
+                    pool.submit([&count] () {
+                        if (sys::thread_pool::current_worker() != -1) { ++count; }
+                    });
+                }
+            });
+        }
+    }
+    expect(value(count.load()) == value(1100));
+}
+
+void test_io_thread_pool() {
+    std::atomic<int> count{0};
+    sys::io_thread_pool pool;
+    for (int i=0; i<10; ++i) { pool.submit([&count] () { ++count; }); }
+    pool.stop();
+    pool.join();
+    expect(value(count.load()) == value(10));
+}
+
+void test_thread_pool_pinned() {
+    std::atomic<int> count{0};
+    const auto cpus = sys::this_process::cpu_affinity();
+    {
+        sys::thread_pool pool(cpus);
+        expect(value(pool.size()) == value(sys::thread_pool::size_type(cpus.count())));
+        for (int i=0; i<100; ++i) {
+            pool.submit([&count,&cpus] () {
+                auto affinity = sys::this_process::cpu_affinity();
+                if (affinity.count() == 1 && (affinity & cpus) == affinity) { ++count; }
+            });
+        }
+    }
+    expect(value(count.load()) == value(100));
+}
+
+void test_thread_pool_pinned_not_allowed() {
+    const auto allowed = sys::this_process::cpu_affinity();
+    sys::static_cpu_set cpus;
+    for (int i=0; i<int(allowed.size()); ++i) {
+        if (!allowed[i]) { cpus.set(i); break; }
+    }
+    if (cpus.count() == 0) { std::exit(77); }
+    expect(throws<sys::bad_call>(call([&] () { sys::thread_pool pool(cpus); })));
+}
@@ -0,0 +1,160 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/net/message_batch>
+
+#if defined(UNISTDX_HAVE_RECVMMSG) && defined(UNISTDX_HAVE_SENDMMSG)
+
+#include <cstring>
+
+#include <unistdx/base/check>
+
+std::uint16_t
+sys::message_batch::message::segment_size() const noexcept {
+    #if defined(UNISTDX_HAVE_UDP_GRO) || defined(UNISTDX_HAVE_UDP_SEGMENT)
+    auto& hdr = const_cast<message_header&>(this->_header->msg_hdr);
+    for (auto* cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level != IPPROTO_UDP) { continue; }
+        #if defined(UNISTDX_HAVE_UDP_GRO)
+        if (cmsg->cmsg_type == UDP_GRO) {
+            int size = 0;
+            std::memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+            return static_cast<std::uint16_t>(size);
+        }
+        #endif
+        #if defined(UNISTDX_HAVE_UDP_SEGMENT)
+        if (cmsg->cmsg_type == UDP_SEGMENT) {
+            std::uint16_t size = 0;
+            std::memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+            return size;
+        }
+        #endif
+    }
+    #endif
+    return 0;
+}
+
+sys::message_batch::message_batch(size_t capacity, size_t message_size,
+                                  size_t control_size):
+_headers(capacity),
+_buffers(capacity),
+_addresses(capacity),
+_data(capacity*message_size),
+_control((capacity*CMSG_ALIGN(control_size) + sizeof(cmessage_header) - 1) /
+         sizeof(cmessage_header)),
+_message_size(message_size),
+_control_size(CMSG_ALIGN(control_size)) {
+    for (size_t i=0; i<capacity; ++i) {
+        auto& hdr = this->_headers[i].msg_hdr;
+        hdr.msg_iov = &this->_buffers[i];
+        hdr.msg_iovlen = 1;
+        this->_buffers[i].iov_base = this->_data.data() + i*message_size;
+        reset(i);
+    }
+}
+
+void
+sys::message_batch::reset(size_t i) noexcept {
+    auto& hdr = this->_headers[i];
+    hdr.msg_len = 0;
+    hdr.msg_hdr.msg_name = &this->_addresses[i];
+    hdr.msg_hdr.msg_namelen = sizeof(socket_address);
+    hdr.msg_hdr.msg_flags = 0;
+    if (this->_control_size == 0) {
+        hdr.msg_hdr.msg_control = nullptr;
+    } else {
+        hdr.msg_hdr.msg_control =
+            reinterpret_cast<char*>(this->_control.data()) + i*this->_control_size;
+    }
+    hdr.msg_hdr.msg_controllen = this->_control_size;
+    this->_buffers[i].iov_len = this->_message_size;
+}
+
+size_t
+sys::message_batch::receive(const socket& s, socket::message_flags flags) {
+    const auto n = capacity();
+    for (size_t i=0; i<n; ++i) { reset(i); }
+    clear();
+    this->_last = s.receive(this->_headers.data(), static_cast<unsigned int>(n), flags);
+    return this->_last;
+}
+
+size_t
+sys::message_batch::send(const socket& s, socket::message_flags flags) {
+    if (empty()) { return 0; }
+    size_t n = s.send(this->_headers.data() + this->_first,
+                      static_cast<unsigned int>(size()), flags);
+    this->_first += n;
+    if (empty()) { clear(); }
+    return n;
+}
+
+void
+sys::message_batch::push_back(const void* data, size_t n, const socket_address* to,
+                              std::uint16_t segment_size) {
+    if (full()) { throw bad_call(std::errc::no_buffer_space); }
+    if (n > this->_message_size) { throw bad_call(std::errc::message_size); }
+    const auto i = this->_last;
+    reset(i);
+    auto& hdr = this->_headers[i];
+    std::memcpy(this->_buffers[i].iov_base, data, n);
+    this->_buffers[i].iov_len = n;
+    hdr.msg_len = static_cast<unsigned int>(n);
+    if (to) {
+        this->_addresses[i] = *to;
+        hdr.msg_hdr.msg_namelen = to->size();
+    } else {
+        hdr.msg_hdr.msg_name = nullptr;
+        hdr.msg_hdr.msg_namelen = 0;
+    }
+    hdr.msg_hdr.msg_controllen = 0;
+    if (segment_size != 0) {
+        #if defined(UNISTDX_HAVE_UDP_SEGMENT)
+        const size_t control_size = CMSG_SPACE(sizeof(segment_size));
+        if (this->_control_size < control_size) {
+            throw bad_call(std::errc::no_buffer_space);
+        }
+        hdr.msg_hdr.msg_controllen = control_size;
+        auto* cmsg = CMSG_FIRSTHDR(&hdr.msg_hdr);
+        cmsg->cmsg_level = IPPROTO_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(segment_size));
+        std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+        #else
+        throw bad_call(std::errc::operation_not_supported);
+        #endif
+    }
+    if (hdr.msg_hdr.msg_controllen == 0) { hdr.msg_hdr.msg_control = nullptr; }
+    ++this->_last;
+}
+
+#endif
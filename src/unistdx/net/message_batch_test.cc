@@ -0,0 +1,117 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <numeric>
+#include <string>
+
+#include <unistdx/net/ipv4_socket_address>
+#include <unistdx/net/message_batch>
+#include <unistdx/net/socket>
+
+#include <unistdx/test/exception>
+#include <unistdx/test/language>
+#include <unistdx/test/operator>
+
+using namespace sys::test::lang;
+
+#if defined(UNISTDX_HAVE_RECVMMSG) && defined(UNISTDX_HAVE_SENDMMSG)
+void test_message_batch_send_receive() {
+    using f = sys::socket_address_family;
+    sys::socket receiver(f::ipv4, sys::socket_type::datagram);
+    receiver.bind(sys::ipv4_socket_address{{127,0,0,1},0});
+    sys::socket sender(f::ipv4, sys::socket_type::datagram);
+    sender.bind(sys::ipv4_socket_address{{127,0,0,1},0});
+    auto to = receiver.name();
+    sys::message_batch out(4, 64);
+    std::string messages[] = {"first", "second", "third"};
+    for (const auto& m : messages) { out.push_back(m.data(), m.size(), to); }
+    expect(value(3u) == value(out.size()));
+    sys::message_batch in(4, 64);
+    expect(value(0u) == value(in.receive(receiver)));
+    while (!out.empty()) { out.send(sender); }
+    size_t n = 0;
+    while (n == 0) { n = in.receive(receiver); }
+    expect(value(3u) == value(n));
+    for (size_t i=0; i<n; ++i) {
+        std::string actual(static_cast<const char*>(in[i].data()), in[i].size());
+        expect(value(messages[i]) == value(actual));
+        expect(value(sender.name()) == value(in[i].address()));
+        expect(value(0u) == value(in[i].segment_size()));
+    }
+}
+
+void test_message_batch_errors() {
+    sys::message_batch batch(1, 4);
+    char data[8] = {};
+    expect(throws<sys::bad_call>(call([&] () { batch.push_back(data, sizeof(data)); })));
+    batch.push_back(data, 4);
+    expect(value(batch.full()));
+    expect(throws<sys::bad_call>(call([&] () { batch.push_back(data, 4); })));
+    batch.clear();
+    expect(value(batch.empty()));
+}
+
+#if defined(UNISTDX_HAVE_UDP_SEGMENT) && defined(UNISTDX_HAVE_UDP_GRO)
+void test_message_batch_segmentation_offload() {
+    using f = sys::socket_address_family;
+    sys::socket receiver(f::ipv4, sys::socket_type::datagram);
+    receiver.bind(sys::ipv4_socket_address{{127,0,0,1},0});
+    receiver.set(sys::socket::udp_options::generic_receive_offload);
+    sys::socket sender(f::ipv4, sys::socket_type::datagram);
+    sender.connect(receiver.name());
+    std::string payload(3000, 'x');
+    sys::message_batch out(1, payload.size());
+    out.push_back(payload.data(), payload.size(), 1000);
+    expect(value(1000u) == value(out[0].segment_size()));
+    try {
+        while (!out.empty()) { out.send(sender); }
+    } catch (const sys::bad_call& err) {
+        // GSO is not supported by the kernel
+        if (err.errc() == std::errc::invalid_argument ||
+            err.errc() == std::errc::no_protocol_option) { return; }
+        throw;
+    }
+    // the datagrams are either coalesced or received as is
+    sys::message_batch in(4, payload.size());
+    size_t total = 0;
+    while (total != payload.size()) {
+        auto n = in.receive(receiver);
+        for (size_t i=0; i<n; ++i) {
+            auto segment_size = in[i].segment_size();
+            expect(value(segment_size == 0 || segment_size == 1000));
+            total += in[i].size();
+        }
+    }
+    expect(value(payload.size()) == value(total));
+}
+#endif
+#endif
@@ -0,0 +1,144 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/net/zero_copy_sender>
+
+#if defined(UNISTDX_HAVE_MSG_ZEROCOPY) && \
+    defined(UNISTDX_HAVE_SO_EE_ORIGIN_ZEROCOPY)
+
+#include <time.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <unistdx/base/check>
+
+sys::zero_copy_sender::zero_copy_sender(socket& s): _socket(s) {
+    this->_socket.set(socket::options::zero_copy);
+}
+
+size_t
+sys::zero_copy_sender::flush() {
+    size_t nwritten = 0;
+    for (auto& e : this->_buffers) {
+        auto& b = e.buffer;
+        while (b.remaining() != 0) {
+            const auto* data = b.data() + b.position();
+            ssize_t n = ::send(this->_socket.fd(), data, b.remaining(),
+                               MSG_ZEROCOPY | MSG_NOSIGNAL);
+            bool zero_copy = true;
+            if (n == -1 && errno == ENOBUFS) {
+                // the pages can not be pinned, fall back to copying
+                n = ::send(this->_socket.fd(), data, b.remaining(), MSG_NOSIGNAL);
+                zero_copy = false;
+            }
+            UNISTDX_CHECK_IO(n);
+            if (n == 0) { release_completed(); return nwritten; }
+            if (zero_copy) {
+                if (e.pending == 0) { e.first = this->_next_id; }
+                ++e.pending;
+                e.last = ++this->_next_id;
+            }
+            b.position(b.position() + n);
+            nwritten += n;
+        }
+    }
+    release_completed();
+    return nwritten;
+}
+
+size_t
+sys::zero_copy_sender::receive_completions() {
+    union {
+        char buffer[CMSG_SPACE(sizeof(::sock_extended_err)+sizeof(::sockaddr_in6))];
+        cmessage_header align;
+    } control;
+    while (true) {
+        message_header hdr{};
+        hdr.msg_control = control.buffer;
+        hdr.msg_controllen = sizeof(control.buffer);
+        if (::recvmsg(this->_socket.fd(), &hdr, MSG_ERRQUEUE) == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+            throw bad_call();
+        }
+        for (auto* cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+            if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                  (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            ::sock_extended_err err{};
+            std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));
+            if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            complete(err.ee_info, err.ee_data);
+            if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) { ++this->_copied; }
+        }
+    }
+    return release_completed();
+}
+
+void
+sys::zero_copy_sender::complete(std::uint32_t lo, std::uint32_t hi) {
+    // the kernel counts send calls modulo 2^32,
+    // the most recent call with the same lower bits is the one
+    auto extend = [this] (std::uint32_t x) -> id_type {
+        return this->_next_id - std::uint32_t(std::uint32_t(this->_next_id) - x);
+    };
+    const auto first = extend(lo), last = extend(hi) + 1;
+    for (auto& e : this->_buffers) {
+        if (e.first >= last) { break; }
+        if (e.pending == 0 || e.last <= first) { continue; }
+        const auto n = std::min(e.last, last) - std::max(e.first, first);
+        e.pending -= std::min(size_t(n), e.pending);
+    }
+}
+
+size_t
+sys::zero_copy_sender::release_completed() {
+    size_t n = 0;
+    while (!this->_buffers.empty()) {
+        auto& e = this->_buffers.front();
+        if (e.buffer.remaining() != 0 || e.pending != 0) { break; }
+        auto& b = e.buffer;
+        b.position(0);
+        b.limit(b.size());
+        this->_released.emplace_back(std::move(b));
+        this->_buffers.pop_front();
+        ++n;
+    }
+    return n;
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include <unistdx/net/ipv4_socket_address>
+#include <unistdx/net/socket>
+#include <unistdx/net/zero_copy_sender>
+
+#include <unistdx/test/language>
+#include <unistdx/test/operator>
+
+using namespace sys::test::lang;
+
+#if defined(UNISTDX_HAVE_MSG_ZEROCOPY) && \
+    defined(UNISTDX_HAVE_SO_EE_ORIGIN_ZEROCOPY)
+void test_zero_copy_sender() {
+    using f = sys::socket_address_family;
+    sys::socket server(f::ipv4);
+    server.bind(sys::ipv4_socket_address{{127,0,0,1},0});
+    server.listen();
+    sys::socket client(f::ipv4);
+    client.unsetf(sys::open_flag::non_blocking);
+    client.connect(server.name());
+    client.setf(sys::open_flag::non_blocking);
+    sys::socket peer;
+    sys::socket_address peer_address;
+    while (!server.accept(peer, peer_address)) {}
+    sys::zero_copy_sender sender(client);
+    const size_t num_buffers = 4, buffer_size = 1024*256;
+    const char* addresses[num_buffers]{};
+    for (size_t i=0; i<num_buffers; ++i) {
+        sys::byte_buffer buffer(buffer_size);
+        for (size_t j=0; j<buffer_size; ++j) { buffer.data()[j] = char(i+j); }
+        buffer.position(buffer_size);
+        buffer.flip();
+        addresses[i] = buffer.data();
+        sender.send(std::move(buffer));
+    }
+    std::vector<char> received, chunk(buffer_size);
+    size_t nreleased = 0;
+    while (!sender.empty() || received.size() != num_buffers*buffer_size) {
+        sender.flush();
+        auto n = peer.read(chunk.data(), chunk.size());
+        received.insert(received.end(), chunk.data(), chunk.data()+n);
+        nreleased += sender.receive_completions();
+    }
+    expect(value(num_buffers) == value(nreleased));
+    expect(value(0u) == value(sender.in_flight()));
+    bool same = true;
+    for (size_t i=0; i<received.size(); ++i) {
+        if (received[i] != char(i/buffer_size + i%buffer_size)) { same = false; }
+    }
+    expect(value(same));
+    sys::byte_buffer buffer;
+    size_t nbuffers = 0;
+    while (sender.release(buffer)) {
+        expect(value(buffer_size) == value(buffer.size()));
+        expect(value(0u) == value(buffer.position()));
+        expect(value(buffer_size) == value(buffer.limit()));
+        expect(value(std::find(addresses, addresses+num_buffers, buffer.data()) !=
+                     addresses+num_buffers));
+        ++nbuffers;
+    }
+    expect(value(num_buffers) == value(nbuffers));
+}
+#endif
@@ -30,12 +30,76 @@ OTHER DEALINGS IN THE SOFTWARE.
 For more information, please refer to <http://unlicense.org/>
 */
 
+#include <dirent.h>
+#include <sched.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <string>
 #include <thread>
 #include <unistdx/system/resource>
 
 namespace {
 
+    constexpr const int num_threads_per_solid_state_drive = 4;
+
+    inline bool has_controller(const std::string& controllers, const char* name) {
+        std::string::size_type first = 0;
+        while (first <= controllers.size()) {
+            auto last = controllers.find(',', first);
+            if (last == std::string::npos) { last = controllers.size(); }
+            if (controllers.compare(first, last-first, name) == 0) { return true; }
+            first = last+1;
+        }
+        return false;
+    }
+
+    // Call the callback for each directory of the control group of the calling
+    // process from the leaf to the root of the hierarchy that contains
+    // the controller. The second argument is the version of the hierarchy.
+    template <class Callback>
+    void for_each_cgroup(const char* controller, Callback callback) {
+        std::ifstream in("/proc/self/cgroup");
+        std::string line;
+        while (std::getline(in, line)) {
+            auto i = line.find(':');
+            if (i == std::string::npos) { continue; }
+            auto j = line.find(':', i+1);
+            if (j == std::string::npos) { continue; }
+            const auto controllers = line.substr(i+1, j-i-1);
+            const auto path = line.substr(j+1);
+            int version = 0;
+            std::string mounts[2];
+            if (controllers.empty()) {
+                version = 2;
+                mounts[0] = "/sys/fs/cgroup";
+                mounts[1] = "/sys/fs/cgroup/unified";
+            } else if (has_controller(controllers, controller)) {
+                version = 1;
+                mounts[0] = "/sys/fs/cgroup/" + controllers;
+                mounts[1] = std::string("/sys/fs/cgroup/") + controller;
+            } else {
+                continue;
+            }
+            for (const auto& mount : mounts) {
+                if (::access((mount + "/cgroup.procs").data(), F_OK) == -1) { continue; }
+                auto p = path;
+                while (true) {
+                    callback(mount + p, version);
+                    if (p.size() <= 1) { break; }
+                    auto k = p.rfind('/');
+                    p.erase(k == 0 ? 1 : k);
+                }
+                break;
+            }
+        }
+    }
+
     inline sys::size_type
     get_size(int name) {
         long result = ::sysconf(name);
@@ -55,7 +119,18 @@ sys::thread_concurrency() noexcept {
         concurrency = std::atoi(cc);
     }
     if (concurrency < 1) {
-        concurrency = std::thread::hardware_concurrency();
+        ::cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        if (::sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+            concurrency = CPU_COUNT(&cpus);
+        }
+        if (concurrency < 1) {
+            concurrency = std::thread::hardware_concurrency();
+        }
+        auto quota = cpu_quota();
+        if (quota > 0) {
+            concurrency = std::min(concurrency, static_cast<int>(std::ceil(quota)));
+        }
     }
     if (concurrency < 1) {
         concurrency = 1; // LCOV_EXCL_LINE
@@ -64,6 +139,85 @@ sys::thread_concurrency() noexcept {
     #endif
 }
 
+unsigned
+sys::io_concurrency() noexcept {
+    #if defined(UNISTDX_SINGLE_THREAD)
+    return 1u;
+    #else
+    int concurrency = 0;
+    const char* cc = std::getenv("UNISTDX_IO_CONCURRENCY");
+    if (cc) {
+        concurrency = std::atoi(cc);
+    }
+    if (concurrency < 1) {
+        concurrency = 0;
+        if (DIR* dir = ::opendir("/sys/block")) {
+            char path[PATH_MAX];
+            while (struct ::dirent* entry = ::readdir(dir)) {
+                if (entry->d_name[0] == '.') { continue; }
+                // skip virtual devices (loop, ram, device mapper etc.)
+                std::snprintf(path, sizeof(path), "/sys/block/%s/device", entry->d_name);
+                if (::access(path, F_OK) == -1) { continue; }
+                std::snprintf(path, sizeof(path), "/sys/block/%s/queue/rotational",
+                              entry->d_name);
+                int rotational = 1;
+                std::ifstream in(path);
+                in >> rotational;
+                concurrency += rotational ? 1 : num_threads_per_solid_state_drive;
+            }
+            ::closedir(dir);
+        }
+    }
+    if (concurrency < 1) {
+        concurrency = 1;
+    }
+    return static_cast<unsigned>(concurrency);
+    #endif
+}
+
+double
+sys::cpu_quota() noexcept {
+    double result = 0;
+    auto update = [&result] (double quota, double period) {
+        if (quota > 0 && period > 0 && (result == 0 || quota/period < result)) {
+            result = quota/period;
+        }
+    };
+    for_each_cgroup("cpu", [&update] (const std::string& dir, int version) {
+        if (version == 2) {
+            std::ifstream in(dir + "/cpu.max");
+            std::string quota;
+            double period = 0;
+            if (in >> quota >> period && quota != "max") {
+                update(std::atof(quota.data()), period);
+            }
+        } else {
+            double quota = 0, period = 0;
+            std::ifstream in(dir + "/cpu.cfs_quota_us");
+            std::ifstream in2(dir + "/cpu.cfs_period_us");
+            if (in >> quota && in2 >> period) {
+                update(quota, period);
+            }
+        }
+    });
+    return result;
+}
+
+auto
+sys::memory_limit() noexcept -> size_type {
+    size_type result = get_size(_SC_PHYS_PAGES)*page_size();
+    auto update = [&result] (size_type limit) {
+        if (limit > 0 && (result == 0 || limit < result)) { result = limit; }
+    };
+    for_each_cgroup("memory", [&update] (const std::string& dir, int version) {
+        std::ifstream in(dir + (version == 2 ? "/memory.max" : "/memory.limit_in_bytes"));
+        size_type limit = 0;
+        // "max" means no limit in cgroup v2
+        if (in >> limit) { update(limit); }
+    });
+    return result;
+}
+
 sys::cache::cache() {
     const int names[4][3] = {
         {_SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL1_DCACHE_LINESIZE, _SC_LEVEL1_DCACHE_ASSOC},
@@ -33,6 +33,7 @@ For more information, please refer to <http://unlicense.org/>
 #include <stdlib.h>
 
 #include <unistdx/io/terminal>
+#include <unistdx/ipc/process>
 #include <unistdx/system/resource>
 #include <unistdx/test/language>
 
@@ -52,6 +53,33 @@ void test_system_thread_concurrency() {
 
 void test_system_io_concurrency() {
     expect(value(sys::io_concurrency()) > value(0u));
+    ::setenv("UNISTDX_IO_CONCURRENCY", "7", 1);
+    expect(value(7u) == value(sys::io_concurrency()));
+    ::setenv("UNISTDX_IO_CONCURRENCY", "0", 1);
+    expect(value(0u) != value(sys::io_concurrency()));
+    ::unsetenv("UNISTDX_IO_CONCURRENCY");
+}
+
+void test_system_cpu_quota() {
+    auto quota = sys::cpu_quota();
+    std::clog << "quota=" << quota << std::endl;
+    expect(value(quota) >= value(0.0));
+}
+
+void test_system_thread_concurrency_affinity() {
+    ::unsetenv("UNISTDX_CONCURRENCY");
+    const auto n = sys::thread_concurrency();
+    expect(value(n) > value(0u));
+    expect(value(n) <= value(unsigned(sys::this_process::cpu_affinity().count())));
+    auto quota = sys::cpu_quota();
+    if (quota > 0) { expect(value(double(n)) <= value(quota+1.0)); }
+}
+
+void test_system_memory_limit() {
+    auto limit = sys::memory_limit();
+    std::clog << "memory_limit=" << limit << std::endl;
+    expect(value(limit) > value(0u));
+    expect(value(limit) <= value(sys::size_type(::sysconf(_SC_PHYS_PAGES))*sys::page_size()));
 }
 
 void test_system_page_size() {
@@ -0,0 +1,194 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <unistdx/io/timer_file_descriptor>
+#include <unistdx/system/timer_wheel>
+
+namespace {
+
+    inline unsigned
+    count_trailing_zeros(std::uint64_t x) noexcept {
+        return static_cast<unsigned>(__builtin_ctzll(x));
+    }
+
+}
+
+sys::timer_wheel::timer_wheel(duration resolution, time_point start):
+_slots(new timer[expiring_slot+1]), _resolution(resolution), _start(start) {
+    if (this->_resolution <= duration::zero()) { this->_resolution = duration(1); }
+    for (unsigned i=0; i<=expiring_slot; ++i) {
+        auto& head = this->_slots[i];
+        head._prev = head._next = &head;
+    }
+}
+
+sys::timer_wheel::~timer_wheel() noexcept {
+    for (unsigned i=0; i<=expiring_slot; ++i) {
+        auto& head = this->_slots[i];
+        auto t = head._next;
+        while (t != &head) {
+            auto next = t->_next;
+            t->_prev = t->_next = nullptr;
+            t->_wheel = nullptr;
+            t = next;
+        }
+        head._prev = head._next = nullptr;
+    }
+}
+
+void sys::timer_wheel::insert(timer& t, time_point expiry) noexcept {
+    if (t._wheel) { t._wheel->erase(t); }
+    auto tick = this->ticks(expiry);
+    if (expiry > this->_start && (expiry - this->_start) % this->_resolution != duration::zero()) {
+        ++tick;
+    }
+    if (tick <= this->_tick) { tick = this->_tick + 1; }
+    t._tick = tick;
+    t._wheel = this;
+    this->link(t);
+    ++this->_size;
+}
+
+void sys::timer_wheel::erase(timer& t) noexcept {
+    if (!t._wheel) { return; }
+    if (t._wheel != this) { t._wheel->erase(t); return; }
+    this->unlink(t);
+    t._wheel = nullptr;
+    --this->_size;
+}
+
+void sys::timer_wheel::link(timer& t) noexcept {
+    const auto delta = t._tick - this->_tick;
+    auto tick = t._tick;
+    unsigned level = 0;
+    while (level != num_levels-1 && delta >= (tick_type(1) << ((level+1)*slot_bits))) {
+        ++level;
+    }
+    if (level == num_levels-1) {
+        const auto max_delta = (tick_type(1) << (num_levels*slot_bits)) - 1;
+        if (delta > max_delta) { tick = this->_tick + max_delta; }
+    }
+    const auto index = unsigned(tick >> (level*slot_bits)) & (num_slots-1);
+    t._slot = level*num_slots + index;
+    auto& head = this->_slots[t._slot];
+    t._next = &head;
+    t._prev = head._prev;
+    head._prev->_next = &t;
+    head._prev = &t;
+    this->_bitmap[level][index/64] |= std::uint64_t(1) << (index%64);
+}
+
+void sys::timer_wheel::unlink(timer& t) noexcept {
+    t._prev->_next = t._next;
+    t._next->_prev = t._prev;
+    t._prev = t._next = nullptr;
+    auto& head = this->_slots[t._slot];
+    if (t._slot != expiring_slot && head._next == &head) {
+        const auto level = t._slot / num_slots, index = t._slot % num_slots;
+        this->_bitmap[level][index/64] &= ~(std::uint64_t(1) << (index%64));
+    }
+}
+
+void sys::timer_wheel::cascade(unsigned level) noexcept {
+    const auto index = unsigned(this->_tick >> (level*slot_bits)) & (num_slots-1);
+    auto& head = this->_slots[level*num_slots + index];
+    if (head._next == &head) { return; }
+    auto t = head._next;
+    head._prev->_next = nullptr;
+    head._prev = head._next = &head;
+    this->_bitmap[level][index/64] &= ~(std::uint64_t(1) << (index%64));
+    while (t) {
+        auto next = t->_next;
+        this->link(*t);
+        t = next;
+    }
+}
+
+void sys::timer_wheel::collect(tick_type target) noexcept {
+    constexpr const tick_type mask = num_slots-1;
+    auto& expiring = this->_slots[expiring_slot];
+    while (this->_tick < target) {
+        if (this->_size == 0) { this->_tick = target; break; }
+        auto next = this->_tick + 1;
+        if ((next & mask) != 0) {
+            // skip empty slots until the end of the lowest level
+            auto slot = this->next_slot(0, unsigned(next & mask));
+            next = slot == -1 ? ((next | mask) + 1) : ((next & ~mask) + tick_type(slot));
+            if (next > target) { this->_tick = target; break; }
+        }
+        this->_tick = next;
+        for (unsigned level=num_levels-1; level!=0; --level) {
+            if ((next & ((tick_type(1) << (level*slot_bits)) - 1)) == 0) {
+                this->cascade(level);
+            }
+        }
+        const auto index = unsigned(next & mask);
+        auto& head = this->_slots[index];
+        if (head._next == &head) { continue; }
+        // move the slot to the end of the expiring list
+        for (auto t = head._next; t != &head; t = t->_next) { t->_slot = expiring_slot; }
+        head._next->_prev = expiring._prev;
+        head._prev->_next = &expiring;
+        expiring._prev->_next = head._next;
+        expiring._prev = head._prev;
+        head._prev = head._next = &head;
+        this->_bitmap[0][index/64] &= ~(std::uint64_t(1) << (index%64));
+    }
+}
+
+int sys::timer_wheel::next_slot(unsigned level, unsigned first) const noexcept {
+    for (unsigned w=first/64; w<num_words; ++w) {
+        auto bits = this->_bitmap[level][w];
+        if (w == first/64) { bits &= ~std::uint64_t(0) << (first%64); }
+        if (bits) { return int(w*64 + count_trailing_zeros(bits)); }
+    }
+    return -1;
+}
+
+auto sys::timer_wheel::next_expiry() const noexcept -> time_point {
+    constexpr const tick_type mask = num_slots-1;
+    if (this->_size == 0) { return time_point::max(); }
+    auto next = this->_tick + 1;
+    if ((next & mask) != 0) {
+        auto slot = this->next_slot(0, unsigned(next & mask));
+        next = slot == -1 ? ((next | mask) + 1) : ((next & ~mask) + tick_type(slot));
+    }
+    return this->time(next);
+}
+
+#if defined(UNISTDX_HAVE_TIMERFD_CREATE)
+void sys::timer_wheel::arm(timer_file_descriptor& fd) const {
+    if (this->_size == 0) { fd.disarm(); return; }
+    // coarse clock lags behind the monotonic one by at most its resolution
+    fd.expire_at(this->next_expiry() + clock_type::resolution());
+}
+#endif
@@ -0,0 +1,196 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <unistdx/io/poller>
+#include <unistdx/io/timer_file_descriptor>
+#include <unistdx/system/timer_wheel>
+
+#include <unistdx/test/language>
+
+using namespace sys::test::lang;
+using namespace std::chrono;
+
+namespace {
+
+    struct connection {
+        sys::timer_wheel::timer timer;
+        sys::timer_wheel::tick_type expired_at = 0;
+        int id = 0;
+    };
+
+    inline connection&
+    to_connection(sys::timer_wheel::timer& t) {
+        return *reinterpret_cast<connection*>(&t);
+    }
+
+}
+
+void test_timer_wheel_levels() {
+    using time_point = sys::timer_wheel::time_point;
+    sys::timer_wheel wheel(milliseconds(1), time_point{});
+    std::vector<milliseconds> delays{
+        milliseconds(5), milliseconds(256), milliseconds(300),
+        seconds(70), hours(5), hours(24*60)
+    };
+    std::vector<connection> conns(delays.size());
+    for (size_t i=0; i<delays.size(); ++i) {
+        conns[i].id = int(i);
+        wheel.insert(conns[i].timer, time_point(delays[i]));
+    }
+    expect(value(delays.size()) == value(wheel.size()));
+    std::vector<int> order;
+    for (size_t i=0; i<delays.size(); ++i) {
+        auto n = wheel.advance(time_point(delays[i]-milliseconds(1)),
+            [&order] (sys::timer_wheel::timer& t) { order.emplace_back(to_connection(t).id); });
+        expect(value(0u) == value(n));
+        expect(value(wheel.next_expiry().time_since_epoch().count()) <=
+               value(time_point(delays[i]).time_since_epoch().count()));
+        n = wheel.advance(time_point(delays[i]),
+            [&order] (sys::timer_wheel::timer& t) { order.emplace_back(to_connection(t).id); });
+        expect(value(1u) == value(n));
+        expect(value(int(i)) == value(order.back()));
+    }
+    expect(value(wheel.empty()));
+    expect(value(time_point::max().time_since_epoch().count()) ==
+           value(wheel.next_expiry().time_since_epoch().count()));
+}
+
+void test_timer_wheel_erase() {
+    using time_point = sys::timer_wheel::time_point;
+    sys::timer_wheel wheel(milliseconds(1), time_point{});
+    connection a, b;
+    wheel.insert(a.timer, milliseconds(10));
+    wheel.insert(b.timer, milliseconds(10));
+    expect(value(a.timer.pending()));
+    wheel.erase(a.timer);
+    expect(!value(a.timer.pending()));
+    wheel.erase(a.timer);
+    {
+        connection c;
+        wheel.insert(c.timer, milliseconds(5));
+        expect(value(2u) == value(wheel.size()));
+    }
+    expect(value(1u) == value(wheel.size()));
+    // reschedule
+    wheel.insert(b.timer, milliseconds(20));
+    expect(value(1u) == value(wheel.size()));
+    size_t n = wheel.advance(time_point(milliseconds(19)), [] (sys::timer_wheel::timer&) {});
+    expect(value(0u) == value(n));
+    n = wheel.advance(time_point(milliseconds(20)), [] (sys::timer_wheel::timer&) {});
+    expect(value(1u) == value(n));
+}
+
+void test_timer_wheel_erase_in_callback() {
+    using time_point = sys::timer_wheel::time_point;
+    sys::timer_wheel wheel(milliseconds(1), time_point{});
+    std::vector<int> fired;
+    std::unique_ptr<connection> a(new connection), b(new connection),
+        c(new connection), d(new connection);
+    a->id = 1, b->id = 2, c->id = 3, d->id = 4;
+    for (auto* x : {a.get(), b.get(), c.get(), d.get()}) {
+        wheel.insert(x->timer, milliseconds(10));
+    }
+    size_t n = wheel.advance(time_point(milliseconds(10)),
+        [&] (sys::timer_wheel::timer& t) {
+            auto id = to_connection(t).id;
+            fired.emplace_back(id);
+            if (id == 1) {
+                // cancel one sibling and destroy the other
+                wheel.erase(b->timer);
+                c.reset();
+            }
+        });
+    expect(value(2u) == value(n));
+    expect(value(std::vector<int>{1,4}) == value(fired));
+    expect(!value(b->timer.pending()));
+    expect(value(wheel.empty()));
+}
+
+void test_timer_wheel_random() {
+    using time_point = sys::timer_wheel::time_point;
+    using tick_type = sys::timer_wheel::tick_type;
+    sys::timer_wheel wheel(milliseconds(1), time_point{});
+    std::mt19937_64 prng;
+    std::uniform_int_distribution<tick_type> expiry(1, tick_type(1) << 26);
+    const size_t n = 10000;
+    std::vector<connection> conns(n);
+    for (auto& c : conns) { wheel.insert(c.timer, time_point(milliseconds(expiry(prng)))); }
+    std::uniform_int_distribution<tick_type> step(1, 1u << 14);
+    tick_type now = 0;
+    size_t nexpired = 0;
+    while (!wheel.empty()) {
+        now += step(prng);
+        nexpired += wheel.advance(time_point(milliseconds(now)),
+            [now] (sys::timer_wheel::timer& t) { to_connection(t).expired_at = now; });
+    }
+    expect(value(n) == value(nexpired));
+    size_t nbad = 0;
+    for (const auto& c : conns) {
+        // expired in the first advance call after the expiration tick
+        if (c.expired_at < c.timer.tick() || c.expired_at >= c.timer.tick() + (1u << 14)) {
+            ++nbad;
+        }
+    }
+    expect(value(0u) == value(nbad));
+}
+
+#if defined(UNISTDX_HAVE_TIMERFD_CREATE)
+void test_timer_wheel_timer_file_descriptor() {
+    sys::timer_wheel wheel;
+    sys::timer_file_descriptor fd;
+    sys::event_poller poller;
+    poller.emplace(fd.fd(), sys::event::in);
+    connection a, b;
+    wheel.insert(a.timer, milliseconds(10));
+    wheel.insert(b.timer, milliseconds(20));
+    wheel.arm(fd);
+    std::mutex mtx;
+    std::unique_lock<std::mutex> lock(mtx);
+    size_t n = 0;
+    const auto t0 = steady_clock::now();
+    while (n != 2 && steady_clock::now()-t0 < seconds(10)) {
+        poller.wait(lock);
+        fd.read();
+        n += wheel.advance([] (sys::timer_wheel::timer&) {});
+        wheel.arm(fd);
+    }
+    expect(value(2u) == value(n));
+    expect(value(0u) == value(fd.read()));
+}
+#endif
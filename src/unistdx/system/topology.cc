@@ -0,0 +1,262 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <string>
+
+#include <unistdx/ipc/process>
+#include <unistdx/system/topology>
+
+namespace {
+
+    const std::string cpu_root = "/sys/devices/system/cpu/";
+    const std::string node_root = "/sys/devices/system/node/";
+
+    template <class T>
+    inline bool read_value(const std::string& path, T& value) {
+        std::ifstream in(path);
+        return bool(in >> value);
+    }
+
+    template <class Set>
+    inline bool read_set(const std::string& path, Set& value) {
+        std::ifstream in(path);
+        if (!in.is_open()) { return false; }
+        // the stream is always in failed state after reading the set
+        in >> value;
+        return value.count() != 0;
+    }
+
+    inline bool read_size(const std::string& path, sys::size_type& value) {
+        std::ifstream in(path);
+        if (!(in >> value)) { return false; }
+        switch (in.peek()) {
+            case 'K': value <<= 10; break;
+            case 'M': value <<= 20; break;
+            case 'G': value <<= 30; break;
+            default: break;
+        }
+        return true;
+    }
+
+    inline sys::cache_type to_cache_type(const std::string& s) noexcept {
+        if (s == "Data") { return sys::cache_type::data; }
+        if (s == "Instruction") { return sys::cache_type::instruction; }
+        return sys::cache_type::unified;
+    }
+
+}
+
+const char* sys::to_string(cache_type rhs) noexcept {
+    switch (rhs) {
+        case cache_type::data: return "data";
+        case cache_type::instruction: return "instruction";
+        case cache_type::unified: return "unified";
+        default: return "unknown";
+    }
+}
+
+std::ostream& sys::operator<<(std::ostream& out, cache_type rhs) {
+    return out << to_string(rhs);
+}
+
+auto sys::cpu_info::data_cache(int level) const noexcept -> const cpu_cache* {
+    const cpu_cache* result = nullptr;
+    for (const auto& c : this->_caches) {
+        if (c.level() == level && c.type() != cache_type::instruction &&
+            (!result || result->size() < c.size())) {
+            result = &c;
+        }
+    }
+    return result;
+}
+
+sys::cpu_topology::cpu_topology() { read(this_process::cpu_affinity()); }
+sys::cpu_topology::cpu_topology(const static_cpu_set& cpus) { read(cpus); }
+
+void sys::cpu_topology::read(const static_cpu_set& cpus) {
+    static_cpu_set online;
+    if (read_set(cpu_root + "online", online)) { online &= cpus; }
+    else { online = cpus; }
+    const auto max_cpus = online.size();
+    for (int i=0; i<max_cpus; ++i) {
+        if (!online[i]) { continue; }
+        cpu_info cpu;
+        cpu._id = i;
+        const auto prefix = cpu_root + "cpu" + std::to_string(i) + '/';
+        if (!read_value(prefix + "topology/core_id", cpu._core)) { cpu._core = i; }
+        if (!read_value(prefix + "topology/physical_package_id", cpu._package)) {
+            cpu._package = 0;
+        }
+        if (!read_set(prefix + "topology/thread_siblings_list", cpu._siblings)) {
+            cpu._siblings.set(i);
+        }
+        for (int j=0; ; ++j) {
+            const auto dir = prefix + "cache/index" + std::to_string(j) + '/';
+            cpu_cache c;
+            if (!read_value(dir + "level", c._level)) { break; }
+            std::string type;
+            if (read_value(dir + "type", type)) { c._type = to_cache_type(type); }
+            read_size(dir + "size", c._size);
+            read_value(dir + "coherency_line_size", c._linesize);
+            read_value(dir + "ways_of_associativity", c._assoc);
+            if (!read_set(dir + "shared_cpu_list", c._cpus)) { c._cpus.set(i); }
+            cpu._caches.emplace_back(std::move(c));
+        }
+        std::stable_sort(cpu._caches.begin(), cpu._caches.end(),
+                         [] (const cpu_cache& a, const cpu_cache& b) {
+                             return a.level() < b.level();
+                         });
+        this->_cpus.emplace_back(std::move(cpu));
+    }
+    node_set nodes;
+    if (!read_set(node_root + "online", nodes)) { nodes.set(0); }
+    const auto max_nodes = nodes.size();
+    // distance files list one value per online node in the order of node ids
+    std::vector<int> online_nodes;
+    for (int i=0; i<max_nodes; ++i) { if (nodes[i]) { online_nodes.emplace_back(i); } }
+    for (int i=0; i<max_nodes; ++i) {
+        if (!nodes[i]) { continue; }
+        numa_node node;
+        node._id = i;
+        const auto prefix = node_root + "node" + std::to_string(i) + '/';
+        if (!read_set(prefix + "cpulist", node._cpus)) {
+            if (i != 0) { continue; }
+            node._cpus = cpu_set();
+        }
+        node._cpus &= online;
+        if (node._cpus.count() == 0) { continue; }
+        {
+            std::ifstream in(prefix + "distance");
+            node._distances.assign(online_nodes.back()+1, 10);
+            int d = 0;
+            for (auto id : online_nodes) {
+                if (!(in >> d)) { break; }
+                node._distances[id] = d;
+            }
+        }
+        for (auto& cpu : this->_cpus) {
+            if (node._cpus[cpu._id]) { cpu._node = i; }
+        }
+        this->_nodes.emplace_back(std::move(node));
+    }
+    this->_quota = cpu_quota();
+}
+
+auto sys::cpu_topology::num_packages() const -> size_type {
+    std::vector<int> packages;
+    for (const auto& cpu : this->_cpus) { packages.emplace_back(cpu.package()); }
+    std::sort(packages.begin(), packages.end());
+    return std::unique(packages.begin(), packages.end()) - packages.begin();
+}
+
+auto sys::cpu_topology::num_cores() const -> size_type {
+    std::vector<std::pair<int,int>> cores;
+    for (const auto& cpu : this->_cpus) { cores.emplace_back(cpu.package(), cpu.core()); }
+    std::sort(cores.begin(), cores.end());
+    return std::unique(cores.begin(), cores.end()) - cores.begin();
+}
+
+unsigned sys::cpu_topology::concurrency() const noexcept {
+    unsigned n = this->_cpus.size();
+    if (this->_quota > 0) {
+        n = std::min(n, static_cast<unsigned>(std::ceil(this->_quota)));
+    }
+    return std::max(n, 1u);
+}
+
+auto sys::cpu_topology::cpu_set() const noexcept -> static_cpu_set {
+    static_cpu_set result;
+    for (const auto& cpu : this->_cpus) { result.set(cpu.id()); }
+    return result;
+}
+
+auto sys::cpu_topology::find(int cpu) const noexcept -> const cpu_info* {
+    auto first = this->_cpus.begin(), last = this->_cpus.end();
+    auto result = std::lower_bound(first, last, cpu,
+                                   [] (const cpu_info& a, int b) { return a.id() < b; });
+    return (result == last || result->id() != cpu) ? nullptr : &*result;
+}
+
+int sys::cpu_topology::distance(int a, int b) const noexcept {
+    if (a == b) { return 0; }
+    const auto* x = find(a);
+    const auto* y = find(b);
+    if (!x || !y) { return std::numeric_limits<int>::max(); }
+    if (x->siblings()[b]) { return 1; }
+    for (const auto& c : x->caches()) {
+        if (c.cpus()[b]) { return 2; }
+    }
+    if (x->node() == y->node() && x->package() == y->package()) { return 3; }
+    for (const auto& node : this->_nodes) {
+        if (node.id() == x->node()) { return 3 + node.distance(y->node()); }
+    }
+    return 3 + 20;
+}
+
+std::ostream& sys::operator<<(std::ostream& out, const cpu_topology& rhs) {
+    out << "packages=" << rhs.num_packages()
+        << ",cores=" << rhs.num_cores()
+        << ",threads=" << rhs.size()
+        << ",quota=" << rhs.quota()
+        << '\n';
+    for (const auto& node : rhs.nodes()) {
+        out << "node=" << node.id() << ",cpus=" << node.cpus() << ",distances=";
+        for (const auto& other : rhs.nodes()) {
+            if (other.id() != rhs.nodes().front().id()) { out << ','; }
+            out << node.distance(other.id());
+        }
+        out << '\n';
+    }
+    for (const auto& cpu : rhs) {
+        out << "cpu=" << cpu.id()
+            << ",core=" << cpu.core()
+            << ",package=" << cpu.package()
+            << ",node=" << cpu.node()
+            << ",siblings=" << cpu.siblings()
+            << '\n';
+        for (const auto& c : cpu.caches()) {
+            out << "  level=" << c.level()
+                << ",type=" << c.type()
+                << ",size=" << c.size()
+                << ",line_size=" << c.line_size()
+                << ",assoc=" << c.associativity()
+                << ",cpus=" << c.cpus()
+                << '\n';
+        }
+    }
+    return out;
+}
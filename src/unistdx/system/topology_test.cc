@@ -0,0 +1,76 @@
+/*
+UNISTDX — C++ library for Linux system calls.
+© 2021 Ivan Gankevich
+
+This file is part of UNISTDX.
+
+This is free and unencumbered software released into the public domain.
+
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include <iostream>
+
+#include <unistdx/ipc/process>
+#include <unistdx/system/topology>
+#include <unistdx/test/language>
+
+using namespace sys::test::lang;
+
+void test_cpu_topology() {
+    sys::cpu_topology topology;
+    std::clog << topology;
+    const auto cpus = sys::this_process::cpu_affinity();
+    expect(value(topology.cpu_set()) == value(cpus));
+    expect(value(topology.size()) == value(sys::size_type(cpus.count())));
+    expect(value(topology.num_packages()) > value(0u));
+    expect(value(topology.num_cores()) > value(0u));
+    expect(value(topology.num_cores()) <= value(topology.size()));
+    expect(value(topology.nodes().size()) > value(0u));
+    expect(value(topology.concurrency()) > value(0u));
+    expect(value(topology.concurrency()) <= value(topology.size()));
+    for (const auto& cpu : topology) {
+        expect(value(topology.find(cpu.id())) == value(&cpu));
+        expect(value(cpu.siblings()[cpu.id()]));
+        expect(value(topology.distance(cpu.id(), cpu.id())) == value(0));
+        for (const auto& other : topology) {
+            expect(value(topology.distance(cpu.id(), other.id())) ==
+                   value(topology.distance(other.id(), cpu.id())));
+        }
+        for (const auto& c : cpu.caches()) {
+            expect(value(c.cpus()[cpu.id()]));
+        }
+    }
+}
+
+void test_cpu_topology_subset() {
+    const auto cpus = sys::this_process::cpu_affinity();
+    int first = 0;
+    while (!cpus[first]) { ++first; }
+    sys::cpu_topology topology(sys::static_cpu_set{first});
+    expect(value(topology.size()) == value(1u));
+    expect(value(topology.concurrency()) == value(1u));
+    expect(value(topology.find(first)) != value(nullptr));
+    expect(value(topology.find(first+1)) == value(nullptr));
+}